@@ -0,0 +1,114 @@
+#include "alias.h"
+#include <stdlib.h>
+#include <assert.h>
+
+/**
+ * Struct: Alias Table
+ *
+ * Implements the storage for the alias table type defined in `alias.h`. The
+ * `n` indices are each given a column of equal total probability, split
+ * between two outcomes:
+ *  `prob`     The chance, within column `i`, of picking `i` itself.
+ *  `alias`    The index picked otherwise.
+ */
+struct alias {
+  double *prob;
+  int *alias;
+  int n;
+};
+
+/**
+ * Create an alias table from the vector `weights`, whose values must each
+ * point to a non-negative `double`, and which must not all be zero.
+ *
+ * The returned table will have been dynamically allocated, and must be
+ * destroyed after use using `alias_destroy`.
+ */
+alias alias_create(const vector weights) {
+  int n = vector_size(weights);
+  assert(n > 0);
+  alias a = malloc(sizeof (struct alias));
+  assert(a != NULL);
+  a->prob = malloc(n * sizeof (double));
+  assert(a->prob != NULL);
+  a->alias = malloc(n * sizeof (int));
+  assert(a->alias != NULL);
+  a->n = n;
+
+  // Scale the weights so that they average 1.
+  double total = 0;
+  for (int i = 0; i < n; i += 1) {
+    double w = *(const double *) vector_get(weights, i);
+    assert(w >= 0);
+    total += w;
+  }
+  assert(total > 0);
+  for (int i = 0; i < n; i += 1) {
+    a->prob[i] = *(const double *) vector_get(weights, i) * n / total;
+  }
+
+  // Sort indices into those under and over average, using the two ends of a
+  // single work array as stacks.
+  int *work = malloc(n * sizeof (int));
+  assert(work != NULL);
+  int small = 0;
+  int large = n;
+  for (int i = 0; i < n; i += 1) {
+    if (a->prob[i] < 1) {
+      work[small] = i;
+      small += 1;
+    } else {
+      large -= 1;
+      work[large] = i;
+    }
+  }
+
+  // Repeatedly fill an under-average column up to 1 with probability taken
+  // from an over-average one, which may then itself drop under average.
+  while (small > 0 && large < n) {
+    small -= 1;
+    int s = work[small];
+    int l = work[large];
+    a->alias[s] = l;
+    a->prob[l] -= 1 - a->prob[s];
+    if (a->prob[l] < 1) {
+      large += 1;
+      work[small] = l;
+      small += 1;
+    }
+  }
+
+  // Whatever's left is (up to rounding error) exactly average.
+  for (int i = 0; i < small; i += 1) a->prob[work[i]] = 1;
+  for (int i = large; i < n; i += 1) a->prob[work[i]] = 1;
+  free(work);
+
+  return a;
+}
+
+/**
+ * Clean up an alias table after use.
+ */
+void alias_destroy(alias a) {
+  free(a->prob);
+  free(a->alias);
+  free(a);
+}
+
+/**
+ * Get the number of indices that `a` samples from.
+ */
+int alias_size(const alias a) {
+  return a->n;
+}
+
+/**
+ * Pick a random index, drawing random numbers from `r`, with probability
+ * proportional to its weight.
+ */
+int alias_sample(const alias a, rng r) {
+
+  // Pick a column uniformly, then one of its two outcomes.
+  int i = rng_below(r, a->n);
+  return rng_double(r) < a->prob[i] ? i : a->alias[i];
+}
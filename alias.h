@@ -0,0 +1,41 @@
+#ifndef __ALIAS_H
+#define __ALIAS_H
+
+#include "vector.h"
+#include "rng.h"
+
+/**
+ * Type: Alias Table
+ *
+ * A precomputed table for weighted random sampling. Given `n` non-negative
+ * weights, it picks index `i` with probability proportional to weight `i`, in
+ * constant time per sample (Vose's alias method).
+ */
+typedef struct alias *alias;
+
+/**
+ * Create an alias table from the vector `weights`, whose values must each
+ * point to a non-negative `double`, and which must not all be zero.
+ *
+ * The returned table will have been dynamically allocated, and must be
+ * destroyed after use using `alias_destroy`.
+ */
+alias alias_create(const vector weights);
+
+/**
+ * Clean up an alias table after use.
+ */
+void alias_destroy(alias a);
+
+/**
+ * Get the number of indices that `a` samples from.
+ */
+int alias_size(const alias a);
+
+/**
+ * Pick a random index, drawing random numbers from `r`, with probability
+ * proportional to its weight.
+ */
+int alias_sample(const alias a, rng r);
+
+#endif
@@ -0,0 +1,254 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include "vector.h"
+#include "ebr.h"
+
+// Values per benchmark vector, and passes over it per measurement.
+#define SIZE (1 << 20)
+#define PASSES 20
+
+// Reads per critical section, for the batched measurement.
+#define BATCH 1024
+
+// Number of reader threads in the contended measurement.
+#define READERS 3
+
+// Values in the random access vector (256MB of pointers), and number of reads
+// from it.
+#define LARGE_SIZE (1 << 25)
+#define RANDOM_READS (1 << 24)
+
+// Shared state for the contended measurement.
+static ebr domain;
+static atomic_bool done;
+
+/**
+ * Get the current time, in nanoseconds.
+ */
+double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * Create a vector holding the numbers 0 through `SIZE - 1`.
+ */
+vector make_vector() {
+  vector v = vector_create();
+  for (int i = 0; i < SIZE; i += 1) vector_push(v, (void *) (intptr_t) i);
+  return v;
+}
+
+/**
+ * Sum the values of `v` in runs of `batch` reads, with a critical section of
+ * `t` around each run (or none, if `t` is NULL), and return the time taken
+ * per read.
+ */
+double time_reads(vector v, ebr_thread t, int batch) {
+  intptr_t sum = 0;
+  double start = now();
+  for (int pass = 0; pass < PASSES; pass += 1) {
+    for (int i = 0; i < SIZE; i += batch) {
+      if (t != NULL) ebr_enter(t);
+      int end = i + batch < SIZE ? i + batch : SIZE;
+      for (int j = i; j < end; j += 1) sum += (intptr_t) vector_get(v, j);
+      if (t != NULL) ebr_exit(t);
+    }
+  }
+  double elapsed = now() - start;
+
+  // Use the sum, so the reads aren't optimized away.
+  if (sum == 42) printf("!");
+  return elapsed / ((double) SIZE * PASSES);
+}
+
+/**
+ * Sum the values of `v` with one optimistic read (see `vector_read_begin`) per
+ * value, and return the time taken per read.
+ */
+double time_optimistic_reads(vector v) {
+  intptr_t sum = 0;
+  double start = now();
+  for (int pass = 0; pass < PASSES; pass += 1) {
+    for (int i = 0; i < SIZE; i += 1) {
+      void *value;
+      unsigned seq;
+      do {
+        seq = vector_read_begin(v);
+        vector_try_get(v, i, &value);
+      } while (vector_read_retry(v, seq));
+      sum += (intptr_t) value;
+    }
+  }
+  double elapsed = now() - start;
+  if (sum == 42) printf("!");
+  return elapsed / ((double) SIZE * PASSES);
+}
+
+/**
+ * Fill a vector of `LARGE_SIZE` values, allocated according to `flags` (see
+ * `vector_use_alloc`), read it at the random indices in `indices`, and return
+ * the time taken per read.
+ */
+double time_random_reads(int flags, const int *indices) {
+  vector v = vector_create();
+  vector_use_alloc(v, flags);
+  for (int i = 0; i < LARGE_SIZE; i += 1) vector_push(v, (void *) (intptr_t) i);
+
+  intptr_t sum = 0;
+  double start = now();
+  for (int k = 0; k < RANDOM_READS; k += 1) {
+    sum += (intptr_t) vector_get(v, indices[k]);
+  }
+  double elapsed = now() - start;
+  if (sum == 42) printf("!");
+
+  vector_destroy(v);
+  return elapsed / RANDOM_READS;
+}
+
+/**
+ * Sum the integers pointed to by the values of `v`, reading them with
+ * `vector_get` (if `batch` is 0) or in batches of `batch` from an iterator
+ * that prefetches the integers, and return the time taken per value.
+ */
+double time_scan(vector v, int batch) {
+  long sum = 0;
+  double start = now();
+  if (batch == 0) {
+    for (int i = 0; i < vector_size(v); i += 1) {
+      sum += *(int *) vector_get(v, i);
+    }
+  } else {
+    void **values = malloc(batch * sizeof (void *));
+    vector_iter it = vector_iter_create(v, true);
+    int n;
+    while ((n = vector_iter_next_batch(it, values, batch)) > 0) {
+      for (int k = 0; k < n; k += 1) sum += *(int *) values[k];
+    }
+    vector_iter_destroy(it);
+    free(values);
+  }
+  double elapsed = now() - start;
+  if (sum == 42) printf("!");
+  return elapsed / vector_size(v);
+}
+
+/**
+ * Size and copy functions for `vector_compact_values` over heap integers. The
+ * originals are freed as they are copied, which is allowed as nothing listens
+ * to the vector.
+ */
+size_t int_size(const void *value) {
+  return sizeof (int);
+}
+
+void int_move(void *dest, const void *value) {
+  *(int *) dest = *(const int *) value;
+  free((void *) value);
+}
+
+/**
+ * Reader thread for the contended measurement: times reads of its own vector
+ * `arg`, one critical section per read, while the writer retires blocks.
+ */
+void *reader(void *arg) {
+  ebr_thread t = ebr_register(domain);
+  double *result = malloc(sizeof (double));
+  *result = time_reads(arg, t, 1);
+  ebr_unregister(t);
+  return result;
+}
+
+/**
+ * Writer thread for the contended measurement: retires blocks as fast as it
+ * can, forcing epoch advances, until the readers are done.
+ */
+void *writer(void *arg) {
+  ebr_thread t = ebr_register(domain);
+  while (!atomic_load(&done)) ebr_retire(t, malloc(64));
+  ebr_unregister(t);
+  return NULL;
+}
+
+int main() {
+  domain = ebr_create();
+  ebr_thread self = ebr_register(domain);
+  vector v = make_vector();
+
+  // Each case is timed against a baseline with the same loop shape, so the
+  // difference is the cost of the critical sections alone.
+  printf("Reader overhead (ns per vector_get):\n");
+  printf("    no critical section          %6.2f\n", time_reads(v, NULL, 1));
+  printf("    one critical section / read  %6.2f\n", time_reads(v, self, 1));
+  printf("    no critical section, %4d    %6.2f\n", BATCH,
+      time_reads(v, NULL, BATCH));
+  printf("    one critical section / %4d  %6.2f\n", BATCH,
+      time_reads(v, self, BATCH));
+  printf("    optimistic read (seqlock)    %6.2f\n",
+      time_optimistic_reads(v));
+
+  // Now with readers on several threads and a writer retiring concurrently.
+  pthread_t readers[READERS];
+  vector vectors[READERS];
+  pthread_t writer_thread;
+  atomic_init(&done, false);
+  pthread_create(&writer_thread, NULL, writer, NULL);
+  for (int k = 0; k < READERS; k += 1) {
+    vectors[k] = make_vector();
+    pthread_create(&readers[k], NULL, reader, vectors[k]);
+  }
+  for (int k = 0; k < READERS; k += 1) {
+    double *result;
+    pthread_join(readers[k], (void **) &result);
+    printf("    contended reader %d           %6.2f\n", k, *result);
+    free(result);
+    vector_destroy(vectors[k]);
+  }
+  atomic_store(&done, true);
+  pthread_join(writer_thread, NULL);
+
+  // Random access over a vector much larger than the TLB's reach.
+  rng r = rng_create(1);
+  int *indices = malloc(RANDOM_READS * sizeof (int));
+  for (int k = 0; k < RANDOM_READS; k += 1) {
+    indices[k] = rng_below(r, LARGE_SIZE);
+  }
+  printf("Random access (ns per vector_get, %dMB of pointers):\n",
+      (int) (LARGE_SIZE * sizeof (void *) >> 20));
+  printf("    default allocation           %6.2f\n",
+      time_random_reads(0, indices));
+  printf("    cache line aligned           %6.2f\n",
+      time_random_reads(VECTOR_ALLOC_ALIGNED, indices));
+  printf("    huge pages                   %6.2f\n",
+      time_random_reads(VECTOR_ALLOC_HUGE, indices));
+  free(indices);
+
+  // Scanning pointers to objects scattered around the heap.
+  vector objects = vector_create();
+  for (int i = 0; i < LARGE_SIZE / 8; i += 1) {
+    int *object = malloc(sizeof (int));
+    *object = i;
+    vector_push(objects, object);
+  }
+  vector_shuffle(objects, r);
+  printf("Scanning pointers to scattered objects (ns per object):\n");
+  printf("    vector_get                   %6.2f\n", time_scan(objects, 0));
+  printf("    iterator, batches of %4d    %6.2f\n", BATCH,
+      time_scan(objects, BATCH));
+  void *arena = vector_compact_values(objects, int_size, int_move);
+  printf("    vector_get, after compacting %6.2f\n", time_scan(objects, 0));
+  free(arena);
+  vector_destroy(objects);
+  rng_destroy(r);
+
+  vector_destroy(v);
+  ebr_unregister(self);
+  ebr_destroy(domain);
+  return 0;
+}
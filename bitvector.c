@@ -0,0 +1,254 @@
+#include "bitvector.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <assert.h>
+
+/**
+ * Struct: Bit Vector
+ *
+ * Implements the storage for the bit vector type defined in `bitvector.h`.
+ * The bit vector struct uses three members:
+ *  `words`    Array of 64-bit words; bit `i` of the bit vector is stored in bit
+ *             `i % 64` of word `i / 64`. Bits past the end are always zero, so
+ *             that whole words can be counted and combined directly.
+ *  `capacity` Number of words allocated.
+ *  `size`     Number of bits currently stored.
+ */
+struct bitvector {
+  uint64_t *words;
+  int capacity;
+  int size;
+};
+
+#define WORD_BITS 64
+
+// Internal helper functions. Implemented at the bottom of this file.
+static int word_count(int bits);
+static uint64_t low_mask(int bits);
+static void extend_if_necessary(bitvector b);
+
+/**
+ * Create a new, empty bit vector.
+ *
+ * The returned bit vector will have been dynamically allocated, and must be
+ * destroyed after use using `bitvector_destroy`.
+ */
+bitvector bitvector_create() {
+  bitvector b = malloc(sizeof (struct bitvector));
+  assert(b != NULL);
+
+  // Start with a single (zeroed) word, for up to 64 bits.
+  b->words = calloc(1, sizeof (uint64_t));
+  assert(b->words != NULL);
+  b->capacity = 1;
+  b->size = 0;
+
+  return b;
+}
+
+/**
+ * Clean up a bit vector after use.
+ */
+void bitvector_destroy(bitvector b) {
+  free(b->words);
+  free(b);
+}
+
+/**
+ * Get the size (number of bits stored) of `b`.
+ */
+int bitvector_size(const bitvector b) {
+  return b->size;
+}
+
+/**
+ * Determine whether `i` is a valid index within `b`.
+ */
+bool bitvector_in_bounds(const bitvector b, int i) {
+  return i < (size_t) b->size;
+}
+
+/**
+ * Write `value` at the existing index `i` in the bit vector `b`.
+ */
+void bitvector_set(bitvector b, int i, bool value) {
+  assert(i < (size_t) b->size);
+  uint64_t bit = (uint64_t) 1 << (i % WORD_BITS);
+  if (value) {
+    b->words[i / WORD_BITS] |= bit;
+  } else {
+    b->words[i / WORD_BITS] &= ~bit;
+  }
+}
+
+/**
+ * Get the value at index `i` in `b`.
+ */
+bool bitvector_get(const bitvector b, int i) {
+  assert(i < (size_t) b->size);
+  return (b->words[i / WORD_BITS] >> (i % WORD_BITS)) & 1;
+}
+
+/**
+ * Insert `value` at index `i` in the bit vector `b`, shifting all existing bits
+ * starting at index `i` one position to the right.
+ */
+void bitvector_insert(bitvector b, int i, bool value) {
+  assert(i <= (size_t) b->size);
+  b->size += 1;
+  extend_if_necessary(b);
+
+  // Shift every whole word after the one containing `i` up by one bit,
+  // carrying in the top bit of the word below.
+  int w = i / WORD_BITS;
+  for (int k = word_count(b->size) - 1; k > w; k -= 1) {
+    b->words[k] = (b->words[k] << 1) | (b->words[k - 1] >> (WORD_BITS - 1));
+  }
+
+  // Within the word containing `i`, only the bits from `i` upwards move.
+  uint64_t mask = low_mask(i % WORD_BITS);
+  uint64_t word = b->words[w];
+  b->words[w] = (word & mask) | ((word & ~mask) << 1) |
+      ((uint64_t) value << (i % WORD_BITS));
+}
+
+/**
+ * Remove and return the value at index `i` of the bit vector `b`.
+ */
+bool bitvector_remove(bitvector b, int i) {
+  bool result = bitvector_get(b, i);
+
+  // Within the word containing `i`, the bits above `i` move down by one, and
+  // the lowest bit of the next word (if any) carries into the top.
+  int w = i / WORD_BITS;
+  int last = word_count(b->size) - 1;
+  uint64_t mask = low_mask(i % WORD_BITS);
+  uint64_t word = b->words[w];
+  b->words[w] = (word & mask) | ((word >> 1) & ~mask);
+
+  // The remaining whole words each shift down by one bit.
+  for (int k = w + 1; k <= last; k += 1) {
+    b->words[k - 1] |= b->words[k] << (WORD_BITS - 1);
+    b->words[k] >>= 1;
+  }
+  b->size -= 1;
+
+  return result;
+}
+
+/**
+ * Push `value` onto the end of the bit vector `b`.
+ */
+void bitvector_push(bitvector b, bool value) {
+  bitvector_insert(b, b->size, value);
+}
+
+/**
+ * Remove and return the value at the end of the bit vector `b`.
+ */
+bool bitvector_pop(bitvector b) {
+  return bitvector_remove(b, b->size - 1);
+}
+
+/**
+ * Count the number of bits in `b` that are set.
+ */
+int bitvector_count(const bitvector b) {
+  return bitvector_rank(b, b->size);
+}
+
+/**
+ * Count the number of set bits in `b` before index `i`. `i` may be anywhere
+ * from 0 to the size of `b`, inclusive.
+ */
+int bitvector_rank(const bitvector b, int i) {
+  assert(i <= (size_t) b->size);
+
+  // Count whole words, then the part of the word containing `i`.
+  int count = 0;
+  int w = i / WORD_BITS;
+  for (int k = 0; k < w; k += 1) {
+    count += __builtin_popcountll(b->words[k]);
+  }
+  if (i % WORD_BITS != 0) {
+    count += __builtin_popcountll(b->words[w] & low_mask(i % WORD_BITS));
+  }
+  return count;
+}
+
+/**
+ * Find the index of the `k`th set bit in `b`, counting from zero, or -1 if `b`
+ * has `k` or fewer bits set.
+ */
+int bitvector_select(const bitvector b, int k) {
+  int words = word_count(b->size);
+  for (int w = 0; w < words; w += 1) {
+
+    // Skip whole words until we reach the one holding the bit we want.
+    uint64_t word = b->words[w];
+    int count = __builtin_popcountll(word);
+    if (k >= count) {
+      k -= count;
+      continue;
+    }
+
+    // Then clear the lowest set bits until it's the lowest one left.
+    for (; k > 0; k -= 1) word &= word - 1;
+    return w * WORD_BITS + __builtin_ctzll(word);
+  }
+  return -1;
+}
+
+/**
+ * Combine `other` into `b` with a bitwise and, or or exclusive or. Both bit
+ * vectors must have the same size.
+ */
+void bitvector_and(bitvector b, const bitvector other) {
+  assert(b->size == other->size);
+  int words = word_count(b->size);
+  for (int k = 0; k < words; k += 1) b->words[k] &= other->words[k];
+}
+
+void bitvector_or(bitvector b, const bitvector other) {
+  assert(b->size == other->size);
+  int words = word_count(b->size);
+  for (int k = 0; k < words; k += 1) b->words[k] |= other->words[k];
+}
+
+void bitvector_xor(bitvector b, const bitvector other) {
+  assert(b->size == other->size);
+  int words = word_count(b->size);
+  for (int k = 0; k < words; k += 1) b->words[k] ^= other->words[k];
+}
+
+/**
+ * Internal helper; computes the number of words needed to hold `bits` bits.
+ */
+static int word_count(int bits) {
+  return (bits + WORD_BITS - 1) / WORD_BITS;
+}
+
+/**
+ * Internal helper; computes a word with just its lowest `bits` bits set, for
+ * `bits` from 0 to 63.
+ */
+static uint64_t low_mask(int bits) {
+  return ((uint64_t) 1 << bits) - 1;
+}
+
+/**
+ * Internal helper; doubles the bit vector's word storage when necessary,
+ * zeroing the new words.
+ */
+static void extend_if_necessary(bitvector b) {
+  int needed = word_count(b->size);
+  if (needed > b->capacity) {
+    int old = b->capacity;
+    b->capacity *= 2;
+    b->words = realloc(b->words, b->capacity * sizeof (uint64_t));
+    assert(b->words != NULL);
+    memset(&b->words[old], 0, (b->capacity - old) * sizeof (uint64_t));
+  }
+}
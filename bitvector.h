@@ -0,0 +1,95 @@
+#ifndef __BITVECTOR_H
+#define __BITVECTOR_H
+
+#include <stdbool.h>
+
+/**
+ * Type: Bit Vector
+ *
+ * Maintains an ordered, variable-length list of boolean values, packed one bit
+ * per value. Supports the same push, pop, insert, remove, get and set
+ * operations as `vector`, along with counting, rank and select queries, and
+ * bitwise combination of whole bit vectors a machine word at a time.
+ */
+typedef struct bitvector *bitvector;
+
+/**
+ * Create a new, empty bit vector.
+ *
+ * The returned bit vector will have been dynamically allocated, and must be
+ * destroyed after use using `bitvector_destroy`.
+ */
+bitvector bitvector_create();
+
+/**
+ * Clean up a bit vector after use.
+ */
+void bitvector_destroy(bitvector b);
+
+/**
+ * Get the size (number of bits stored) of `b`.
+ */
+int bitvector_size(const bitvector b);
+
+/**
+ * Determine whether `i` is a valid index within `b`.
+ */
+bool bitvector_in_bounds(const bitvector b, int i);
+
+/**
+ * Write `value` at the existing index `i` in the bit vector `b`.
+ */
+void bitvector_set(bitvector b, int i, bool value);
+
+/**
+ * Get the value at index `i` in `b`.
+ */
+bool bitvector_get(const bitvector b, int i);
+
+/**
+ * Insert `value` at index `i` in the bit vector `b`, shifting all existing bits
+ * starting at index `i` one position to the right.
+ */
+void bitvector_insert(bitvector b, int i, bool value);
+
+/**
+ * Remove and return the value at index `i` of the bit vector `b`.
+ */
+bool bitvector_remove(bitvector b, int i);
+
+/**
+ * Push `value` onto the end of the bit vector `b`.
+ */
+void bitvector_push(bitvector b, bool value);
+
+/**
+ * Remove and return the value at the end of the bit vector `b`.
+ */
+bool bitvector_pop(bitvector b);
+
+/**
+ * Count the number of bits in `b` that are set.
+ */
+int bitvector_count(const bitvector b);
+
+/**
+ * Count the number of set bits in `b` before index `i`. `i` may be anywhere
+ * from 0 to the size of `b`, inclusive.
+ */
+int bitvector_rank(const bitvector b, int i);
+
+/**
+ * Find the index of the `k`th set bit in `b`, counting from zero, or -1 if `b`
+ * has `k` or fewer bits set.
+ */
+int bitvector_select(const bitvector b, int k);
+
+/**
+ * Combine `other` into `b` with a bitwise and, or or exclusive or. Both bit
+ * vectors must have the same size.
+ */
+void bitvector_and(bitvector b, const bitvector other);
+void bitvector_or(bitvector b, const bitvector other);
+void bitvector_xor(bitvector b, const bitvector other);
+
+#endif
@@ -0,0 +1,118 @@
+#include "bloom.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <assert.h>
+
+/**
+ * Struct: Bloom Filter
+ *
+ * Implements the storage for the bloom filter type defined in `bloom.h`. The
+ * filter bits are divided into blocks of one cache line (512 bits) each:
+ *  `words`    The filter bits, `BLOCK_WORDS` words per block.
+ *  `blocks`   Number of blocks.
+ *  `capacity` Number of hashes the filter was sized for.
+ * Each hash picks one block, and then sets (or tests) `PROBES` bits within
+ * that block.
+ */
+#define BLOCK_WORDS 8
+#define PROBES 6
+
+// About ten bits per hash gives roughly a 1% false positive rate.
+#define BITS_PER_HASH 10
+
+struct bloom {
+  uint64_t *words;
+  int blocks;
+  int capacity;
+};
+
+// Internal helper functions. Implemented at the bottom of this file.
+static uint64_t mix(uint64_t x);
+static uint64_t *find_block(const bloom b, uint64_t hash);
+
+/**
+ * Create a new, empty bloom filter sized to hold about `capacity` hashes.
+ *
+ * The returned filter will have been dynamically allocated, and must be
+ * destroyed after use using `bloom_destroy`.
+ */
+bloom bloom_create(int capacity) {
+  bloom b = malloc(sizeof (struct bloom));
+  assert(b != NULL);
+  b->capacity = capacity > 0 ? capacity : 1;
+  b->blocks = ((long) b->capacity * BITS_PER_HASH + 511) / 512;
+
+  // Align the words to cache lines, so that each block really does sit in a
+  // single line.
+  b->words = aligned_alloc(64, b->blocks * BLOCK_WORDS * sizeof (uint64_t));
+  assert(b->words != NULL);
+  for (int i = 0; i < b->blocks * BLOCK_WORDS; i += 1) b->words[i] = 0;
+
+  return b;
+}
+
+/**
+ * Clean up a bloom filter after use.
+ */
+void bloom_destroy(bloom b) {
+  free(b->words);
+  free(b);
+}
+
+/**
+ * Get the number of hashes that `b` was sized to hold.
+ */
+int bloom_capacity(const bloom b) {
+  return b->capacity;
+}
+
+/**
+ * Add `hash` to the filter `b`.
+ */
+void bloom_add(bloom b, uint64_t hash) {
+  uint64_t *block = find_block(b, hash);
+
+  // Each probe takes the next nine bits of a remixed hash as a bit position
+  // within the 512-bit block.
+  uint64_t bits = mix(mix(hash));
+  for (int k = 0; k < PROBES; k += 1) {
+    int bit = (bits >> (k * 9)) & 511;
+    block[bit / 64] |= (uint64_t) 1 << (bit % 64);
+  }
+}
+
+/**
+ * Test whether `hash` may have been added to `b`. A false result is certain;
+ * a true result may be a false positive.
+ */
+bool bloom_test(const bloom b, uint64_t hash) {
+  const uint64_t *block = find_block(b, hash);
+  uint64_t bits = mix(mix(hash));
+  for (int k = 0; k < PROBES; k += 1) {
+    int bit = (bits >> (k * 9)) & 511;
+    if (!(block[bit / 64] >> (bit % 64) & 1)) return false;
+  }
+  return true;
+}
+
+/**
+ * Internal helper; scrambles the bits of `x`, so that every output bit
+ * depends on every input bit (the MurmurHash3 finalizer). Client hashes may
+ * be weak, like raw pointers.
+ */
+static uint64_t mix(uint64_t x) {
+  x = (x ^ (x >> 33)) * 0xff51afd7ed558ccd;
+  x = (x ^ (x >> 33)) * 0xc4ceb9fe1a85ec53;
+  return x ^ (x >> 33);
+}
+
+/**
+ * Internal helper; picks the block of `b` used by `hash`, by mapping the low
+ * half of the mixed hash onto the range of block numbers (without a
+ * division).
+ */
+static uint64_t *find_block(const bloom b, uint64_t hash) {
+  uint64_t index = ((mix(hash) & 0xffffffff) * b->blocks) >> 32;
+  return &b->words[index * BLOCK_WORDS];
+}
@@ -0,0 +1,47 @@
+#ifndef __BLOOM_H
+#define __BLOOM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Type: Bloom Filter
+ *
+ * A compact, approximate set of 64-bit hashes. Testing a hash that was added
+ * always succeeds; testing one that wasn't usually fails, but may succeed by
+ * chance (about 1% of the time while the filter holds no more than its
+ * capacity). Each hash touches a single 64-byte block of the filter, so both
+ * adding and testing cost at most one cache miss.
+ */
+typedef struct bloom *bloom;
+
+/**
+ * Create a new, empty bloom filter sized to hold about `capacity` hashes.
+ *
+ * The returned filter will have been dynamically allocated, and must be
+ * destroyed after use using `bloom_destroy`.
+ */
+bloom bloom_create(int capacity);
+
+/**
+ * Clean up a bloom filter after use.
+ */
+void bloom_destroy(bloom b);
+
+/**
+ * Get the number of hashes that `b` was sized to hold.
+ */
+int bloom_capacity(const bloom b);
+
+/**
+ * Add `hash` to the filter `b`.
+ */
+void bloom_add(bloom b, uint64_t hash);
+
+/**
+ * Test whether `hash` may have been added to `b`. A false result is certain;
+ * a true result may be a false positive.
+ */
+bool bloom_test(const bloom b, uint64_t hash);
+
+#endif
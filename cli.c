@@ -1,9 +1,61 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include "vector.h"
 
 #define MAX_LINE 80
+#define MAX_FOLLOWERS 16
+
+// Most bytes of log a leader holds for a follower that isn't reading, before
+// giving up on it.
+#define MAX_BACKLOG (16 << 20)
+
+// Stores the vector manipulated by the shell.
+static vector v = NULL;
+
+// Replication state. A leader (`--replicate-to`) listens on `listen_fd` for
+// followers at the socket file `socket_path`, keeps their connections in `followers`, and collects a log of
+// changes in `log_buf` to send them after each command. Followers are written
+// to without blocking, so each has a `backlog` of log it hasn't taken yet. A
+// follower (`--follow`, marked by `is_follower`) is connected to its leader on
+// `leader_fd` (until the leader goes away), and keeps any partial line of the
+// leader's log in `pending`.
+struct follower {
+  int fd;
+  char *backlog;
+  int backlog_len;
+};
+
+static int listen_fd = -1;
+static char *socket_path = NULL;
+static struct follower followers[MAX_FOLLOWERS];
+static int follower_count = 0;
+static char *log_buf = NULL;
+static int log_len = 0;
+static int log_cap = 0;
+static bool is_follower = false;
+static int leader_fd = -1;
+static char pending[2 * MAX_LINE + 16];
+static int pending_len = 0;
+
+// Transaction state. While a transaction is open, values the shell's vector
+// stops holding are kept in `dropped` rather than freed, in case the
+// transaction is aborted; and values it starts holding are noted in
+// `created`, to free if it is. A leader holds back its log while a
+// transaction is open, and `txn_mark` is where the transaction's changes
+// begin in it.
+static bool txn_open = false;
+static vector created = NULL;
+static vector dropped = NULL;
+static int txn_mark = 0;
 
 /**
  * Read at most `MAX_LINE` characters (plus terminal newline) from `stdin` into
@@ -121,18 +173,99 @@ bool parse_iv(char *line, char *cmd, int *i, char **value) {
   return true;
 }
 
+/**
+ * Append a line, formatted by `printf` rules, to the leader's replication log.
+ */
+void log_line(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+/**
+ * Listener for changes to the shell's vector, on a leader. Records each change
+ * in the replication log as the shell command that would reproduce it.
+ */
+void log_change(void *context, enum vector_op op, int i, void *old_value,
+    void *new_value) {
+  switch (op) {
+    case VECTOR_SET:
+      log_line("set %d %s\n", i, (char *) new_value);
+      break;
+    case VECTOR_INSERT:
+      log_line("insert %d %s\n", i, (char *) new_value);
+      break;
+    case VECTOR_REMOVE:
+      log_line("remove %d\n", i);
+      break;
+    case VECTOR_PUSH:
+      log_line("push %s\n", (char *) new_value);
+      break;
+    case VECTOR_POP:
+      log_line("pop\n");
+      break;
+  }
+}
+
+/**
+ * Replace the shell's vector with a new, empty one. On a leader, this is
+ * logged, and the new vector's changes are logged from then on.
+ */
+void reset_vector() {
+  do_cleanup(v);
+  v = vector_create();
+  if (listen_fd >= 0) {
+    log_line("init\n");
+    vector_subscribe(v, log_change, NULL);
+  }
+}
+
+/**
+ * Note that the shell's vector has started holding `value`.
+ */
+void keep_value(char *value) {
+  if (txn_open) vector_push(created, value);
+}
+
+/**
+ * Free `value`, which the shell's vector has stopped holding; or, within a
+ * transaction, hold on to it until the transaction ends.
+ */
+void drop_value(char *value) {
+  if (txn_open) {
+    vector_push(dropped, value);
+  } else {
+    free(value);
+  }
+}
+
+/**
+ * End the open transaction, freeing the values in `garbage` (either `created`
+ * or `dropped`).
+ */
+void end_txn(vector garbage) {
+  do_cleanup(garbage);
+  vector_destroy(garbage == created ? dropped : created);
+  created = NULL;
+  dropped = NULL;
+  txn_open = false;
+}
+
 /**
  * Accepts a command string `command` and runs the correct routine.
  */
 void run_cmd(char *line) {
 
-  // Stores the vector manipulated by the shell.
-  static vector v = NULL;
-
   // Extract the command from the string using `strtok`.
   char *cmd = strtok(line, " ");
   if (cmd == NULL) return;
 
+  // Followers only serve reads; their vector changes only through the leader.
+  if (is_follower && (strcmp(cmd, "init") == 0 ||
+      strcmp(cmd, "set") == 0 || strcmp(cmd, "insert") == 0 ||
+      strcmp(cmd, "remove") == 0 || strcmp(cmd, "push") == 0 ||
+      strcmp(cmd, "pop") == 0 || strcmp(cmd, "begin") == 0 ||
+      strcmp(cmd, "commit") == 0 || strcmp(cmd, "abort") == 0)) {
+    printf("    error; read-only follower\n");
+    return;
+  }
+
   // Command: `help`. List commands.
   if (strcmp(cmd, "help") == 0) {
     if (!parse(line, cmd)) return;
@@ -147,6 +280,9 @@ void run_cmd(char *line) {
     printf("    remove <i>          Remove the value at index <i>\n");
     printf("    push <value>        Push <value> to end of vector\n");
     printf("    pop                 Remove the value at end of vector\n");
+    printf("    begin               Begin a transaction\n");
+    printf("    commit              Keep the changes since `begin`\n");
+    printf("    abort               Undo the changes since `begin`\n");
   }
 
   // Command: `exit`, `quit`. Closes the shell.
@@ -159,8 +295,13 @@ void run_cmd(char *line) {
   // Command: `init`. Creates a new, empty vector.
   else if (strcmp(cmd, "init") == 0) {
     if (!parse(line, cmd)) return;
-    do_cleanup(v);
-    v = vector_create();
+
+    // The old vector can't be brought back by an abort.
+    if (txn_open) {
+      printf("    error; transaction open\n");
+      return;
+    }
+    reset_vector();
     printf("    v = []\n");
   }
 
@@ -194,7 +335,10 @@ void run_cmd(char *line) {
     if (!vector_in_bounds(v, i)) {
       printf("    error; out of bounds\n");
     } else {
+      char *old_value = vector_get(v, i);
       vector_set(v, i, value);
+      drop_value(old_value);
+      keep_value(value);
       printf("    v[%d] = %s\n", i, value);
     }
   }
@@ -226,6 +370,7 @@ void run_cmd(char *line) {
       printf("    error; out of bounds\n");
     } else {
       vector_insert(v, i, value);
+      keep_value(value);
       printf("    v[%d] = %s\n", i, value);
     }
   }
@@ -242,7 +387,7 @@ void run_cmd(char *line) {
     } else {
       char *value = vector_remove(v, i);
       printf("    # v[%d] = %s\n", i, value);
-      free(value);
+      drop_value(value);
     }
   }
 
@@ -253,6 +398,7 @@ void run_cmd(char *line) {
     if (!parse_v(line, cmd, &value)) return;
     if (!ensure_exists(v)) return;
     vector_push(v, value);
+    keep_value(value);
     printf("    v[%d] = %s\n", vector_size(v) - 1, value);
   }
 
@@ -267,7 +413,56 @@ void run_cmd(char *line) {
     } else {
       char *value = vector_pop(v);
       printf("    # v[%d] = %s\n", vector_size(v), value);
-      free(value);
+      drop_value(value);
+    }
+  }
+
+  // Command: `begin`. Begins a transaction.
+  else if (strcmp(cmd, "begin") == 0) {
+    if (!parse(line, cmd)) return;
+    if (!ensure_exists(v)) return;
+
+    // Transactions don't nest.
+    if (txn_open) {
+      printf("    error; transaction open\n");
+    } else {
+      vector_txn_begin(v);
+      txn_open = true;
+      created = vector_create();
+      dropped = vector_create();
+      txn_mark = log_len;
+      printf("    # begin\n");
+    }
+  }
+
+  // Command: `commit`. Keeps the changes made since `begin`.
+  else if (strcmp(cmd, "commit") == 0) {
+    if (!parse(line, cmd)) return;
+    if (!ensure_exists(v)) return;
+
+    if (!txn_open) {
+      printf("    error; no transaction\n");
+    } else {
+      vector_txn_commit(v);
+      end_txn(dropped);
+      printf("    # commit\n");
+    }
+  }
+
+  // Command: `abort`. Undoes the changes made since `begin`.
+  else if (strcmp(cmd, "abort") == 0) {
+    if (!parse(line, cmd)) return;
+    if (!ensure_exists(v)) return;
+
+    // Followers never saw the transaction's changes, so neither they nor the
+    // changes undoing them need to be sent.
+    if (!txn_open) {
+      printf("    error; no transaction\n");
+    } else {
+      vector_txn_abort(v);
+      end_txn(created);
+      log_len = txn_mark;
+      printf("    # abort\n");
     }
   }
 
@@ -276,13 +471,306 @@ void run_cmd(char *line) {
   }
 }
 
-int main() {
+void log_line(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(NULL, 0, format, args);
+  va_end(args);
+
+  // Grow the log by doubling, like a vector.
+  if (log_len + length + 1 > log_cap) {
+    if (log_cap == 0) log_cap = 256;
+    while (log_len + length + 1 > log_cap) log_cap *= 2;
+    log_buf = realloc(log_buf, log_cap);
+  }
+  va_start(args, format);
+  vsnprintf(log_buf + log_len, length + 1, format, args);
+  va_end(args);
+  log_len += length;
+}
+
+/**
+ * Parse a replication address of the form `unix:<path>` into `addr`. Returns
+ * `true`/`false` to indicate success.
+ */
+bool parse_address(const char *spec, struct sockaddr_un *addr) {
+  if (strncmp(spec, "unix:", 5) != 0) return false;
+  const char *path = spec + 5;
+  if (*path == '\0' || strlen(path) >= sizeof addr->sun_path) return false;
+  memset(addr, 0, sizeof *addr);
+  addr->sun_family = AF_UNIX;
+  strcpy(addr->sun_path, path);
+  return true;
+}
+
+/**
+ * On a leader, remove the socket file when the shell exits, so that followers
+ * can't connect to a leader that is gone.
+ */
+void remove_socket() {
+  unlink(socket_path);
+}
+
+/**
+ * Start listening for followers at `addr`, as a leader. Returns `true`/`false`
+ * to indicate success.
+ */
+bool start_leader(struct sockaddr_un *addr) {
+
+  // Writes to a follower that has gone away should fail, not kill us.
+  signal(SIGPIPE, SIG_IGN);
+
+  // A socket left behind by an earlier leader must be removed before we can
+  // bind, but nothing else at the path may be touched.
+  struct stat st;
+  if (lstat(addr->sun_path, &st) == 0) {
+    if (!S_ISSOCK(st.st_mode)) {
+      errno = EEXIST;
+      return false;
+    }
+    unlink(addr->sun_path);
+  }
+
+  listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listen_fd < 0) return false;
+  if (bind(listen_fd, (struct sockaddr *) addr, sizeof *addr) < 0 ||
+      listen(listen_fd, MAX_FOLLOWERS) < 0) {
+    return false;
+  }
+  socket_path = strdup(addr->sun_path);
+  atexit(remove_socket);
+
+  // Accepting must never block the shell.
+  fcntl(listen_fd, F_SETFL, fcntl(listen_fd, F_GETFL) | O_NONBLOCK);
+  return true;
+}
+
+/**
+ * Connect to the leader at `addr`, as a follower. Returns `true`/`false` to
+ * indicate success.
+ */
+bool start_follower(struct sockaddr_un *addr) {
+  is_follower = true;
+  leader_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (leader_fd < 0) return false;
+  return connect(leader_fd, (struct sockaddr *) addr, sizeof *addr) == 0;
+}
+
+/**
+ * Queue the `length` bytes of `data` for follower `f`, and send as much of its
+ * backlog as it will take without blocking. Returns `false` if the follower
+ * has gone, or has fallen too far behind to keep.
+ */
+bool send_to(struct follower *f, const char *data, int length) {
+  if (f->backlog_len + length > MAX_BACKLOG) return false;
+  f->backlog = realloc(f->backlog, f->backlog_len + length + 1);
+  memcpy(f->backlog + f->backlog_len, data, length);
+  f->backlog_len += length;
+
+  int sent = 0;
+  while (sent < f->backlog_len) {
+    ssize_t n = write(f->fd, f->backlog + sent, f->backlog_len - sent);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+    if (n <= 0) return false;
+    sent += n;
+  }
+  memmove(f->backlog, f->backlog + sent, f->backlog_len - sent);
+  f->backlog_len -= sent;
+  return true;
+}
+
+/**
+ * On a leader, accept any followers waiting to connect, and bring each up to
+ * date by sending it the current vector as an `init` and a series of `push`es.
+ */
+void accept_followers() {
+  while (true) {
+    int fd = accept(listen_fd, NULL, NULL);
+    if (fd < 0) return;
+    if (follower_count == MAX_FOLLOWERS) {
+      close(fd);
+      continue;
+    }
+
+    // Accepted sockets don't inherit non-blocking mode from the listening
+    // one, and a follower that isn't reading must never block us.
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    // Build the snapshot in the (currently empty) log, send it, and discard
+    // it again.
+    if (v != NULL) {
+      log_line("init\n");
+      for (int i = 0; i < vector_size(v); i += 1) {
+        log_line("push %s\n", (char *) vector_get(v, i));
+      }
+    }
+    struct follower *f = &followers[follower_count];
+    f->fd = fd;
+    f->backlog = NULL;
+    f->backlog_len = 0;
+    if (send_to(f, log_buf, log_len)) {
+      follower_count += 1;
+    } else {
+      close(fd);
+      free(f->backlog);
+    }
+    log_len = 0;
+  }
+}
+
+/**
+ * On a leader, send the changes logged by the last command (and anything
+ * still backed up) to every follower. Followers that have gone, or fallen too
+ * far behind, are dropped.
+ */
+void flush_log() {
+  for (int k = 0; k < follower_count; ) {
+    if (send_to(&followers[k], log_buf, log_len)) {
+      k += 1;
+    } else {
+      close(followers[k].fd);
+      free(followers[k].backlog);
+      follower_count -= 1;
+      followers[k] = followers[follower_count];
+    }
+  }
+  log_len = 0;
+}
+
+/**
+ * On a follower, parse the index `arg` from a line of the leader's log into
+ * `i`, which must be below `limit`. Returns `true`/`false` to indicate
+ * success.
+ */
+bool parse_log_index(const char *arg, int limit, int *i) {
+  if (arg == NULL) return false;
+  char *end;
+  errno = 0;
+  long index = strtol(arg, &end, 10);
+  if (end == arg || *end != '\0' || errno != 0 || index < 0 ||
+      index >= limit) {
+    return false;
+  }
+  *i = (int) index;
+  return true;
+}
+
+/**
+ * On a follower, apply one line `line` of the leader's log to the vector.
+ * Values are owned by the follower's vector, just as in the leader's. Returns
+ * `false` without changing anything if the line is malformed or doesn't fit
+ * the vector, meaning we are out of step with the leader.
+ */
+bool apply_log(char *line) {
+  char *cmd = strtok(line, " ");
+  char *arg = strtok(NULL, " ");
+  char *value = strtok(NULL, " ");
+  int i;
+  if (cmd == NULL) return false;
+
+  if (strcmp(cmd, "init") == 0 && arg == NULL) {
+    do_cleanup(v);
+    v = vector_create();
+  } else if (v == NULL) {
+    return false;
+  } else if (strcmp(cmd, "set") == 0 && value != NULL &&
+      parse_log_index(arg, vector_size(v), &i)) {
+    free(vector_get(v, i));
+    vector_set(v, i, strdup(value));
+  } else if (strcmp(cmd, "insert") == 0 && value != NULL &&
+      parse_log_index(arg, vector_size(v) + 1, &i)) {
+    vector_insert(v, i, strdup(value));
+  } else if (strcmp(cmd, "remove") == 0 && value == NULL &&
+      parse_log_index(arg, vector_size(v), &i)) {
+    free(vector_remove(v, i));
+  } else if (strcmp(cmd, "push") == 0 && arg != NULL && value == NULL) {
+    vector_push(v, strdup(arg));
+  } else if (strcmp(cmd, "pop") == 0 && arg == NULL && vector_size(v) > 0) {
+    free(vector_pop(v));
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/**
+ * On a follower, apply everything the leader has sent so far, without
+ * waiting for more.
+ */
+void sync_follower() {
+  while (leader_fd >= 0) {
+    ssize_t got = recv(leader_fd, pending + pending_len,
+        sizeof pending - pending_len, MSG_DONTWAIT);
+    if (got < 0 && errno == EINTR) continue;
+    if (got < 0) return;
+
+    // The leader has gone; keep serving what we have.
+    if (got == 0) {
+      printf("    # leader disconnected; serving last known state\n");
+      close(leader_fd);
+      leader_fd = -1;
+      return;
+    }
+
+    // Apply each complete line, and keep any partial line for next time.
+    pending_len += got;
+    int start = 0;
+    for (int k = 0; k < pending_len; k += 1) {
+      if (pending[k] == '\n') {
+        pending[k] = '\0';
+
+        // Applying anything more after a bad line would only compound the
+        // damage; keep serving what we have, as if the leader had gone.
+        if (!apply_log(pending + start)) {
+          printf("    # bad line from leader; disconnected\n");
+          close(leader_fd);
+          leader_fd = -1;
+          pending_len = 0;
+          return;
+        }
+        start = k + 1;
+      }
+    }
+    memmove(pending, pending + start, pending_len - start);
+    pending_len -= start;
+  }
+}
+
+int main(int argc, char **argv) {
+
+  // Set up replication, if asked to.
+  struct sockaddr_un addr;
+  if (argc == 3 && strcmp(argv[1], "--replicate-to") == 0 &&
+      parse_address(argv[2], &addr)) {
+    if (!start_leader(&addr)) {
+      perror("vector-cli: --replicate-to");
+      return 1;
+    }
+  } else if (argc == 3 && strcmp(argv[1], "--follow") == 0 &&
+      parse_address(argv[2], &addr)) {
+    if (!start_follower(&addr)) {
+      perror("vector-cli: --follow");
+      return 1;
+    }
+  } else if (argc != 1) {
+    fprintf(stderr, "usage: %s [--replicate-to unix:<path> | "
+        "--follow unix:<path>]\n", argv[0]);
+    return 1;
+  }
 
   printf("Vector CLI; use `help` if you are totally lost.\n");
 
+  // A leader takes on new followers and ships its log around each command
+  // (but holds both off until any open transaction ends, so that followers
+  // receive a transaction's changes all at once); a follower catches up on its
+  // leader's log before each command.
   char command[MAX_LINE + 1];
   while (read_cmd(command)) {
+    if (leader_fd >= 0) sync_follower();
+    if (listen_fd >= 0 && !txn_open) accept_followers();
     run_cmd(command);
+    if (listen_fd >= 0 && !txn_open) flush_log();
   }
 
   return 0;
@@ -0,0 +1,420 @@
+#include "diff.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+/**
+ * Struct: Diff
+ *
+ * Implements the storage for the diff type defined in `diff.h`. Each hunk is
+ * described by a `struct hunk`:
+ *  `index`    Position in the new vector at which the hunk applies.
+ *  `removed`  Number of old values removed there.
+ *  `inserted` Number of new values inserted in their place.
+ *  `offset`   Index into the diff's `values` of the first inserted value.
+ *
+ * The diff keeps the hunks, and all their inserted values, in two arrays that
+ * double in capacity as needed.
+ */
+struct hunk {
+  int index;
+  int removed;
+  int inserted;
+  int offset;
+};
+
+struct diff {
+  struct hunk *hunks;
+  int count;
+  int capacity;
+  void **values;
+  int value_count;
+  int value_capacity;
+};
+
+// Myers' algorithm keeps a record of its search for every edit distance it
+// tries, which takes space quadratic in the distance. Beyond this distance, we
+// stop looking for a minimal diff, and split the values in two instead.
+#define MAX_DISTANCE 1024
+
+// How many values in a row must match for a split to anchor on them, and how
+// many places near the middle are tried as anchors before giving up.
+#define ANCHOR_RUN 8
+#define ANCHOR_TRIES 8
+
+// Edit operations found by Myers' algorithm.
+enum op { KEEP, REMOVE, INSERT };
+
+// Internal helper functions. Implemented at the bottom of this file.
+static void begin_hunk(diff d, int index, int removed);
+static void add_value(diff d, void *value);
+static int edit_range(const vector a, const vector b, int x, int n, int y,
+    int m, map_equal_fn equal, char *ops);
+static int find_edits(const vector a, const vector b, int x, int n, int y,
+    int m, map_equal_fn equal, char *ops);
+static bool find_anchor(const vector a, const vector b, int x, int n, int y,
+    int m, map_equal_fn equal, int *i, int *j);
+static bool same(map_equal_fn equal, const void *x, const void *y);
+
+/**
+ * Create a new, empty diff, to be filled in with `diff_add_hunk` (*e.g.*, when
+ * reconstructing a diff received from elsewhere).
+ *
+ * The returned diff will have been dynamically allocated, and must be
+ * destroyed after use using `diff_destroy`.
+ */
+diff diff_create() {
+  diff d = malloc(sizeof (struct diff));
+  assert(d != NULL);
+  d->hunks = malloc(sizeof (struct hunk));
+  assert(d->hunks != NULL);
+  d->count = 0;
+  d->capacity = 1;
+  d->values = malloc(sizeof (void *));
+  assert(d->values != NULL);
+  d->value_count = 0;
+  d->value_capacity = 1;
+  return d;
+}
+
+/**
+ * Clean up a diff after use.
+ */
+void diff_destroy(diff d) {
+  free(d->hunks);
+  free(d->values);
+  free(d);
+}
+
+/**
+ * Get the number of hunks in `d`.
+ */
+int diff_hunks(const diff d) {
+  return d->count;
+}
+
+/**
+ * Get the total number of values removed or inserted by `d`.
+ */
+int diff_size(const diff d) {
+  int size = d->value_count;
+  for (int h = 0; h < d->count; h += 1) {
+    size += d->hunks[h].removed;
+  }
+  return size;
+}
+
+/**
+ * Describe hunk `h` of `d`: its index is stored in `index`, the number of
+ * values it removes in `removed`, and a pointer to the values it inserts in
+ * `values`. Returns the number of values inserted.
+ */
+int diff_hunk(const diff d, int h, int *index, int *removed,
+    void *const **values) {
+  assert(h < (size_t) d->count);
+  struct hunk *hunk = &d->hunks[h];
+  *index = hunk->index;
+  *removed = hunk->removed;
+  *values = &d->values[hunk->offset];
+  return hunk->inserted;
+}
+
+/**
+ * Append a hunk to `d` that removes `removed` values at `index` and inserts
+ * the `count` values in `values` in their place. `index` must be at least the
+ * end of the previous hunk's inserted values.
+ */
+void diff_add_hunk(diff d, int index, int removed, void *const *values,
+    int count) {
+  begin_hunk(d, index, removed);
+  for (int k = 0; k < count; k += 1) {
+    add_value(d, values[k]);
+  }
+}
+
+/**
+ * Compute a diff that turns `a` into `b`, comparing values with `equal`. The
+ * diff is minimal (by Myers' algorithm) for small changes; for large ones it
+ * may replace more values than strictly necessary, but stays proportional to
+ * the change as long as unchanged runs of values remain between the edits.
+ *
+ * Identical pointers (including two NULLs) are equal without calling `equal`,
+ * and NULL is unequal to anything else, so `equal` is never passed NULL.
+ *
+ * Changes confined to one end of the vector, such as appends, are found in
+ * linear time without any search.
+ */
+diff vector_diff(const vector a, const vector b, map_equal_fn equal) {
+  diff d = diff_create();
+  int n = vector_size(a);
+  int m = vector_size(b);
+  char *ops = malloc((n + m > 0 ? n + m : 1) * sizeof (char));
+  assert(ops != NULL);
+  int count = edit_range(a, b, 0, n, 0, m, equal, ops);
+
+  // Group consecutive edits into hunks, tracking our position in `b`.
+  int y = 0;
+  bool open = false;
+  for (int k = 0; k < count; k += 1) {
+    if (ops[k] == KEEP) {
+      open = false;
+      y += 1;
+      continue;
+    }
+    if (!open) {
+      begin_hunk(d, y, 0);
+      open = true;
+    }
+    if (ops[k] == REMOVE) {
+      d->hunks[d->count - 1].removed += 1;
+    } else {
+      add_value(d, vector_get(b, y));
+      y += 1;
+    }
+  }
+  free(ops);
+
+  return d;
+}
+
+/**
+ * Apply the diff `d` to `v`, which must hold the same values as the vector the
+ * diff was computed from.
+ */
+void vector_patch(vector v, const diff d) {
+
+  // Each hunk is one splice, so the tail of the vector moves once per hunk
+  // rather than once per value.
+  for (int h = 0; h < d->count; h += 1) {
+    struct hunk *hunk = &d->hunks[h];
+    vector_splice(v, hunk->index, hunk->removed, &d->values[hunk->offset],
+        hunk->inserted);
+  }
+}
+
+/**
+ * Internal helper; appends a new hunk to `d` with no inserted values (yet).
+ */
+static void begin_hunk(diff d, int index, int removed) {
+  if (d->count > 0) {
+    struct hunk *last = &d->hunks[d->count - 1];
+    assert(index >= last->index + last->inserted);
+  }
+  if (d->count == d->capacity) {
+    d->capacity *= 2;
+    d->hunks = realloc(d->hunks, d->capacity * sizeof (struct hunk));
+    assert(d->hunks != NULL);
+  }
+
+  struct hunk *hunk = &d->hunks[d->count];
+  hunk->index = index;
+  hunk->removed = removed;
+  hunk->inserted = 0;
+  hunk->offset = d->value_count;
+  d->count += 1;
+}
+
+/**
+ * Internal helper; appends `value` to the inserted values of the last hunk in
+ * `d`.
+ */
+static void add_value(diff d, void *value) {
+  if (d->value_count == d->value_capacity) {
+    d->value_capacity *= 2;
+    d->values = realloc(d->values, d->value_capacity * sizeof (void *));
+    assert(d->values != NULL);
+  }
+  d->values[d->value_count] = value;
+  d->value_count += 1;
+  d->hunks[d->count - 1].inserted += 1;
+}
+
+/**
+ * Internal helper; finds an edit script turning the `n` values of `a` from
+ * index `x` into the `m` values of `b` from index `y`. The operations are
+ * written to `ops` in order, and their number is returned.
+ */
+static int edit_range(const vector a, const vector b, int x, int n, int y,
+    int m, map_equal_fn equal, char *ops) {
+
+  // Strip the common prefix and suffix. Most incremental changes (appends,
+  // truncations, edits in one place) leave nothing else, so they need no
+  // search at all.
+  int start = 0;
+  while (start < n && start < m &&
+      same(equal, vector_get(a, x + start), vector_get(b, y + start))) {
+    start += 1;
+  }
+  int end = 0;
+  while (end < n - start && end < m - start && same(equal,
+      vector_get(a, x + n - 1 - end), vector_get(b, y + m - 1 - end))) {
+    end += 1;
+  }
+  memset(ops, KEEP, start);
+  int count = start;
+  x += start;
+  y += start;
+  n -= start + end;
+  m -= start + end;
+
+  // Find the edits needed within the middle. If there are too many, split it
+  // where the two sides line up, so that scattered edits still give a diff
+  // the size of the change; only when nothing lines up is the whole middle
+  // replaced.
+  int found = n == 0 || m == 0 ? -1 :
+      find_edits(a, b, x, n, y, m, equal, ops + count);
+  int i, j;
+  if (found >= 0) {
+    count += found;
+  } else if (n > 0 && m > 0 &&
+      find_anchor(a, b, x, n, y, m, equal, &i, &j)) {
+    count += edit_range(a, b, x, i - x, y, j - y, equal, ops + count);
+    count += edit_range(a, b, i, x + n - i, j, y + m - j, equal,
+        ops + count);
+  } else {
+    memset(ops + count, REMOVE, n);
+    memset(ops + count + n, INSERT, m);
+    count += n + m;
+  }
+
+  memset(ops + count, KEEP, end);
+  return count + end;
+}
+
+/**
+ * Internal helper; runs Myers' algorithm to find a shortest edit script
+ * turning the `n` values of `a` from index `start_a` into the `m` values of
+ * `b` from index `start_b`. The operations are written to `ops` in order, and
+ * their number is returned; or, if the script would need more than
+ * `MAX_DISTANCE` edits, -1 is returned instead.
+ */
+static int find_edits(const vector a, const vector b, int start_a, int n,
+    int start_b, int m, map_equal_fn equal, char *ops) {
+
+  // `reach[k]` is the furthest `x` reached so far on diagonal `k = x - y`.
+  // After trying each distance `d`, the live part of `reach` (diagonals `-d`
+  // to `d`) is saved in `trace[d]`, so the path can be recovered afterwards.
+  int limit = n + m < MAX_DISTANCE ? n + m : MAX_DISTANCE;
+  int *reach = malloc((2 * limit + 3) * sizeof (int));
+  assert(reach != NULL);
+  int **trace = malloc((limit + 1) * sizeof (int *));
+  assert(trace != NULL);
+  reach += limit + 1;
+  reach[1] = 0;
+
+  int found = -1;
+  for (int d = 0; d <= limit && found < 0; d += 1) {
+    for (int k = -d; k <= d; k += 2) {
+
+      // Step down (an insertion) from diagonal `k + 1`, or right (a removal)
+      // from diagonal `k - 1`, whichever gets further; then follow matching
+      // values along the diagonal as far as they go.
+      int x = k == -d || (k != d && reach[k - 1] < reach[k + 1]) ?
+          reach[k + 1] : reach[k - 1] + 1;
+      int y = x - k;
+      while (x < n && y < m &&
+          same(equal, vector_get(a, start_a + x), vector_get(b, start_b + y))) {
+        x += 1;
+        y += 1;
+      }
+      reach[k] = x;
+      if (x >= n && y >= m) {
+        found = d;
+        break;
+      }
+    }
+    trace[d] = malloc((2 * d + 1) * sizeof (int));
+    assert(trace[d] != NULL);
+    memcpy(trace[d], &reach[-d], (2 * d + 1) * sizeof (int));
+  }
+  free(reach - limit - 1);
+
+  // Walk back from the end, recovering each step from the saved reaches of
+  // the distance before it. The operations come out in reverse order.
+  int count = 0;
+  if (found >= 0) {
+    int x = n;
+    int y = m;
+    for (int d = found; d > 0; d -= 1) {
+      int *prev = trace[d - 1] + d - 1;
+      int k = x - y;
+      bool down = k == -d || (k != d && prev[k - 1] < prev[k + 1]);
+      int prev_k = down ? k + 1 : k - 1;
+      int prev_x = prev[prev_k];
+      int snake = down ? prev_x : prev_x + 1;
+      for (; x > snake; x -= 1, y -= 1) {
+        ops[count] = KEEP;
+        count += 1;
+      }
+      ops[count] = down ? INSERT : REMOVE;
+      count += 1;
+      x = prev_x;
+      y = prev_x - prev_k;
+    }
+    for (; x > 0; x -= 1) {
+      ops[count] = KEEP;
+      count += 1;
+    }
+
+    // Put the operations back in forwards order.
+    for (int i = 0, j = count - 1; i < j; i += 1, j -= 1) {
+      char tmp = ops[i];
+      ops[i] = ops[j];
+      ops[j] = tmp;
+    }
+  }
+
+  int tried = found >= 0 ? found : limit;
+  for (int d = 0; d <= tried; d += 1) {
+    free(trace[d]);
+  }
+  free(trace);
+
+  return found >= 0 ? count : -1;
+}
+
+/**
+ * Internal helper; determines whether values `x` and `y` are equal, without
+ * passing NULL to `equal`.
+ */
+static bool same(map_equal_fn equal, const void *x, const void *y) {
+  if (x == y) return true;
+  if (x == NULL || y == NULL) return false;
+  return equal(x, y);
+}
+
+/**
+ * Internal helper; looks for a place to split the `n` values of `a` from index
+ * `x` and the `m` values of `b` from index `y`: indices `i` in `a` and `j` in
+ * `b`, near the middle of each, at which `ANCHOR_RUN` values match in a row.
+ * Returns `true`/`false` to indicate whether one was found.
+ */
+static bool find_anchor(const vector a, const vector b, int x, int n, int y,
+    int m, map_equal_fn equal, int *i, int *j) {
+
+  // Try a few places in the middle of `a`, in case the middle itself was
+  // edited. Each is looked for in `b` around the same relative position,
+  // spreading outwards up to `MAX_DISTANCE` places either side, as values
+  // inserted or removed before it shift it by no more than that.
+  for (int t = 0; t < ANCHOR_TRIES; t += 1) {
+    int at = x + n / 2 + t * ANCHOR_RUN;
+    if (at + ANCHOR_RUN > x + n) break;
+    int expected = y + (int) ((long long) (at - x) * m / n);
+    for (int k = 0; k <= 2 * MAX_DISTANCE; k += 1) {
+      int to = expected + (k % 2 ? (k + 1) / 2 : -k / 2);
+      if (to < y || to + ANCHOR_RUN > y + m) continue;
+      int r = 0;
+      while (r < ANCHOR_RUN &&
+          same(equal, vector_get(a, at + r), vector_get(b, to + r))) {
+        r += 1;
+      }
+      if (r == ANCHOR_RUN) {
+        *i = at;
+        *j = to;
+        return true;
+      }
+    }
+  }
+  return false;
+}
@@ -0,0 +1,82 @@
+#ifndef __DIFF_H
+#define __DIFF_H
+
+#include "vector.h"
+#include "map.h"
+
+/**
+ * Type: Diff
+ *
+ * An edit script that turns one vector into another, as a list of hunks. Each
+ * hunk removes some values at an index and inserts others in their place.
+ * Hunks are ordered by index, and each index counts positions in the *new*
+ * vector, so that applying the hunks in order, front to back, always edits
+ * the right place. A diff's size is proportional to the size of the change,
+ * not of the vectors, which makes it cheap to send elsewhere to bring a copy
+ * up to date.
+ *
+ * Like vectors, diffs store values by reference.
+ */
+typedef struct diff *diff;
+
+/**
+ * Create a new, empty diff, to be filled in with `diff_add_hunk` (*e.g.*, when
+ * reconstructing a diff received from elsewhere).
+ *
+ * The returned diff will have been dynamically allocated, and must be
+ * destroyed after use using `diff_destroy`.
+ */
+diff diff_create();
+
+/**
+ * Clean up a diff after use.
+ */
+void diff_destroy(diff d);
+
+/**
+ * Get the number of hunks in `d`.
+ */
+int diff_hunks(const diff d);
+
+/**
+ * Get the total number of values removed or inserted by `d`.
+ */
+int diff_size(const diff d);
+
+/**
+ * Describe hunk `h` of `d`: its index is stored in `index`, the number of
+ * values it removes in `removed`, and a pointer to the values it inserts in
+ * `values`. Returns the number of values inserted.
+ */
+int diff_hunk(const diff d, int h, int *index, int *removed,
+    void *const **values);
+
+/**
+ * Append a hunk to `d` that removes `removed` values at `index` and inserts
+ * the `count` values in `values` in their place. `index` must be at least the
+ * end of the previous hunk's inserted values.
+ */
+void diff_add_hunk(diff d, int index, int removed, void *const *values,
+    int count);
+
+/**
+ * Compute a diff that turns `a` into `b`, comparing values with `equal`. The
+ * diff is minimal (by Myers' algorithm) for small changes; for large ones it
+ * may replace more values than strictly necessary, but stays proportional to
+ * the change as long as unchanged runs of values remain between the edits.
+ *
+ * Identical pointers (including two NULLs) are equal without calling `equal`,
+ * and NULL is unequal to anything else, so `equal` is never passed NULL.
+ *
+ * Changes confined to one end of the vector, such as appends, are found in
+ * linear time without any search.
+ */
+diff vector_diff(const vector a, const vector b, map_equal_fn equal);
+
+/**
+ * Apply the diff `d` to `v`, which must hold the same values as the vector the
+ * diff was computed from.
+ */
+void vector_patch(vector v, const diff d);
+
+#endif
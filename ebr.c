@@ -0,0 +1,213 @@
+#include "ebr.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <assert.h>
+
+/**
+ * Struct: Epoch-Based Reclamation Domain
+ *
+ * Implements the storage for the types defined in `ebr.h`. The domain holds:
+ *  `epoch`    The global epoch.
+ *  `threads`  Linked list of every thread record ever registered. Records are
+ *             never removed from it, only marked free for reuse.
+ *
+ * Each thread record holds:
+ *  `state`    The epoch the thread last entered a critical section in,
+ *             shifted left by one, with the low bit set while the thread is
+ *             inside it. Only the thread itself writes this.
+ *  `depth`    How deeply the thread's critical sections are nested.
+ *  `limbo`    Blocks the thread has retired but not yet freed, each with the
+ *             global epoch at the time (`count` of `capacity`).
+ *  `in_use`   Whether the record belongs to a registered thread.
+ */
+struct ebr {
+  _Atomic uint64_t epoch;
+  _Atomic (struct ebr_thread *) threads;
+};
+
+struct retired {
+  void *block;
+  uint64_t epoch;
+};
+
+struct ebr_thread {
+  ebr domain;
+  _Atomic uint64_t state;
+  int depth;
+  struct retired *limbo;
+  int count;
+  int capacity;
+  atomic_bool in_use;
+  struct ebr_thread *next;
+};
+
+// How many retired blocks a thread collects before trying to free them.
+#define BATCH 64
+
+// Internal helper functions. Implemented at the bottom of this file.
+static bool try_advance(ebr e);
+
+/**
+ * Create a new reclamation domain, with no threads registered.
+ *
+ * The returned domain will have been dynamically allocated, and must be
+ * destroyed after use using `ebr_destroy`.
+ */
+ebr ebr_create() {
+  ebr e = malloc(sizeof (struct ebr));
+  assert(e != NULL);
+  atomic_init(&e->epoch, 0);
+  atomic_init(&e->threads, NULL);
+  return e;
+}
+
+/**
+ * Clean up a reclamation domain after use, freeing every block still waiting
+ * to be freed. No thread may be using the domain any longer.
+ */
+void ebr_destroy(ebr e) {
+  struct ebr_thread *t = atomic_load(&e->threads);
+  while (t != NULL) {
+    struct ebr_thread *next = t->next;
+    for (int k = 0; k < t->count; k += 1) {
+      free(t->limbo[k].block);
+    }
+    free(t->limbo);
+    free(t);
+    t = next;
+  }
+  free(e);
+}
+
+/**
+ * Register the calling thread with `e`, returning its record.
+ */
+ebr_thread ebr_register(ebr e) {
+
+  // Reuse the record of a thread that has unregistered, if there is one.
+  for (struct ebr_thread *t = atomic_load(&e->threads); t != NULL;
+      t = t->next) {
+    bool expected = false;
+    if (atomic_compare_exchange_strong(&t->in_use, &expected, true)) {
+      return t;
+    }
+  }
+
+  // Otherwise, add a new record to the front of the list.
+  struct ebr_thread *t = malloc(sizeof (struct ebr_thread));
+  assert(t != NULL);
+  t->domain = e;
+  atomic_init(&t->state, 0);
+  t->depth = 0;
+  t->limbo = NULL;
+  t->count = 0;
+  t->capacity = 0;
+  atomic_init(&t->in_use, true);
+  t->next = atomic_load(&e->threads);
+  while (!atomic_compare_exchange_weak(&e->threads, &t->next, t));
+  return t;
+}
+
+/**
+ * Unregister a thread's record `t`, when the thread is done with the domain.
+ * Blocks it retired are freed now if no reader can still be using them, and
+ * otherwise later (at the latest, by `ebr_destroy`).
+ */
+void ebr_unregister(ebr_thread t) {
+  assert(t->depth == 0);
+
+  // Blocks retired in the current epoch need it to advance twice before they
+  // can go, which it can do here at once if no reader is holding it back.
+  ebr_collect(t);
+  if (t->count > 0) ebr_collect(t);
+  atomic_store(&t->in_use, false);
+}
+
+/**
+ * Enter a critical section on the thread of `t`. Memory read from shared
+ * structures protected by the domain stays valid until the matching
+ * `ebr_exit`. Critical sections may nest.
+ */
+void ebr_enter(ebr_thread t) {
+  t->depth += 1;
+  if (t->depth > 1) return;
+
+  // Announce the epoch we are reading in. The fence keeps our reads of shared
+  // memory from happening before the announcement is visible to writers.
+  uint64_t epoch = atomic_load_explicit(&t->domain->epoch,
+      memory_order_relaxed);
+  atomic_store_explicit(&t->state, epoch << 1 | 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+}
+
+/**
+ * Exit a critical section on the thread of `t`.
+ */
+void ebr_exit(ebr_thread t) {
+  assert(t->depth > 0);
+  t->depth -= 1;
+  if (t->depth > 0) return;
+  uint64_t state = atomic_load_explicit(&t->state, memory_order_relaxed);
+  atomic_store_explicit(&t->state, state & ~(uint64_t) 1,
+      memory_order_release);
+}
+
+/**
+ * Free `block` (with `free`) once no reader can still be using it. `block`
+ * must already be unreachable from shared structures.
+ */
+void ebr_retire(ebr_thread t, void *block) {
+  if (t->count == t->capacity) {
+    t->capacity = t->capacity ? t->capacity * 2 : BATCH;
+    t->limbo = realloc(t->limbo, t->capacity * sizeof (struct retired));
+    assert(t->limbo != NULL);
+  }
+
+  // Tag the block with the global epoch, rather than our own: a reader may
+  // have entered in the global epoch and picked up the block before it was
+  // unlinked, even if we entered earlier.
+  t->limbo[t->count].block = block;
+  t->limbo[t->count].epoch = atomic_load(&t->domain->epoch);
+  t->count += 1;
+  if (t->count % BATCH == 0) ebr_collect(t);
+}
+
+/**
+ * Free every block retired by the thread of `t` that is now safe to free.
+ * This happens automatically as blocks are retired, once enough are waiting;
+ * a thread that retires few, large blocks should call it itself now and then.
+ */
+void ebr_collect(ebr_thread t) {
+  try_advance(t->domain);
+
+  // Once the epoch has advanced twice since a block was retired, every
+  // reader active then has since exited.
+  uint64_t epoch = atomic_load(&t->domain->epoch);
+  int kept = 0;
+  for (int k = 0; k < t->count; k += 1) {
+    if (t->limbo[k].epoch + 2 <= epoch) {
+      free(t->limbo[k].block);
+    } else {
+      t->limbo[kept] = t->limbo[k];
+      kept += 1;
+    }
+  }
+  t->count = kept;
+}
+
+/**
+ * Internal helper; advances the global epoch of `e` if every thread inside a
+ * critical section has seen its current value. Returns `true`/`false` to
+ * indicate whether it did.
+ */
+static bool try_advance(ebr e) {
+  uint64_t epoch = atomic_load(&e->epoch);
+  for (struct ebr_thread *t = atomic_load(&e->threads); t != NULL;
+      t = t->next) {
+    uint64_t state = atomic_load(&t->state);
+    if ((state & 1) && state >> 1 != epoch) return false;
+  }
+  return atomic_compare_exchange_strong(&e->epoch, &epoch, epoch + 1);
+}
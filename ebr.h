@@ -0,0 +1,81 @@
+#ifndef __EBR_H
+#define __EBR_H
+
+/**
+ * Type: Epoch-Based Reclamation Domain
+ *
+ * Defers freeing memory that other threads may still be reading until they
+ * no longer can be. Readers bracket each access to shared memory with
+ * `ebr_enter` and `ebr_exit`; a writer that unlinks a block of memory hands it
+ * to `ebr_retire` instead of `free`, and it is freed once every reader that
+ * might have seen it has exited.
+ *
+ * The domain tracks a global epoch, which advances only once every thread
+ * inside a critical section has seen its current value. A block retired in
+ * one epoch is therefore unreachable by the time the epoch has advanced
+ * twice more. Entering and exiting cost a store each, with no shared writes
+ * beyond the thread's own record; retired blocks are freed in batches.
+ */
+typedef struct ebr *ebr;
+
+/**
+ * Type: Epoch-Based Reclamation Thread
+ *
+ * A thread's registration with an `ebr` domain. Each thread that reads or
+ * retires memory protected by the domain needs its own, and only that thread
+ * may use it.
+ */
+typedef struct ebr_thread *ebr_thread;
+
+/**
+ * Create a new reclamation domain, with no threads registered.
+ *
+ * The returned domain will have been dynamically allocated, and must be
+ * destroyed after use using `ebr_destroy`.
+ */
+ebr ebr_create();
+
+/**
+ * Clean up a reclamation domain after use, freeing every block still waiting
+ * to be freed. No thread may be using the domain any longer.
+ */
+void ebr_destroy(ebr e);
+
+/**
+ * Register the calling thread with `e`, returning its record.
+ */
+ebr_thread ebr_register(ebr e);
+
+/**
+ * Unregister a thread's record `t`, when the thread is done with the domain.
+ * Blocks it retired are freed now if no reader can still be using them, and
+ * otherwise later (at the latest, by `ebr_destroy`).
+ */
+void ebr_unregister(ebr_thread t);
+
+/**
+ * Enter a critical section on the thread of `t`. Memory read from shared
+ * structures protected by the domain stays valid until the matching
+ * `ebr_exit`. Critical sections may nest.
+ */
+void ebr_enter(ebr_thread t);
+
+/**
+ * Exit a critical section on the thread of `t`.
+ */
+void ebr_exit(ebr_thread t);
+
+/**
+ * Free `block` (with `free`) once no reader can still be using it. `block`
+ * must already be unreachable from shared structures.
+ */
+void ebr_retire(ebr_thread t, void *block);
+
+/**
+ * Free every block retired by the thread of `t` that is now safe to free.
+ * This happens automatically as blocks are retired, once enough are waiting;
+ * a thread that retires few, large blocks should call it itself now and then.
+ */
+void ebr_collect(ebr_thread t);
+
+#endif
@@ -0,0 +1,276 @@
+#include "map.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <assert.h>
+
+/**
+ * Struct: Map
+ *
+ * Implements the storage for the map type defined in `map.h`, as an
+ * open-addressing hash table with Robin Hood linear probing. Entries live in
+ * two parallel arrays:
+ *  `dists`    One control byte per slot: 0 if the slot is empty, otherwise one
+ *             more than the entry's distance from its home slot, saturating
+ *             at `MAX_DIST`. Probing scans only this compact array until a
+ *             candidate is found.
+ *  `slots`    Key/value pairs.
+ * Plus some metadata:
+ *  `capacity` Number of slots; always a power of two.
+ *  `shift`    Right shift that maps a mixed 64-bit hash onto a slot index.
+ *  `size`     Number of entries currently stored.
+ */
+struct slot {
+  void *key;
+  void *value;
+};
+
+struct map {
+  unsigned char *dists;
+  struct slot *slots;
+  int capacity;
+  int shift;
+  int size;
+  map_hash_fn hash;
+  map_equal_fn equal;
+};
+
+// Robin Hood probing keeps distances short, but a control byte can only
+// record so much. Entries further from home are all recorded as this distance,
+// and probing past it falls back to comparing every key. Only many keys with
+// the same hash get this far, and growing the table wouldn't separate them.
+#define MAX_DIST 255
+
+// Internal helper functions. Implemented at the bottom of this file.
+static int find_slot(const map m, const void *key);
+static int slot_dist(const map m, int i);
+static void insert_new(map m, void *key, void *value);
+static void allocate(map m, int capacity);
+static void grow(map m);
+
+/**
+ * Create a new, empty map whose keys are hashed with `hash` and compared with
+ * `equal`.
+ *
+ * The returned map will have been dynamically allocated, and must be destroyed
+ * after use using `map_destroy`.
+ */
+map map_create(map_hash_fn hash, map_equal_fn equal) {
+  map m = malloc(sizeof (struct map));
+  assert(m != NULL);
+  m->hash = hash;
+  m->equal = equal;
+  m->size = 0;
+
+  // Start with a small table; it doubles as needed, just like a vector.
+  allocate(m, 8);
+  return m;
+}
+
+/**
+ * Clean up a map after use.
+ *
+ * Like `vector_destroy`, this frees only the map's own storage, and not the
+ * keys or values that it references.
+ */
+void map_destroy(map m) {
+  free(m->dists);
+  free(m->slots);
+  free(m);
+}
+
+/**
+ * Get the number of entries stored in `m`.
+ */
+int map_size(const map m) {
+  return m->size;
+}
+
+/**
+ * Determine whether `m` contains an entry for `key`.
+ */
+bool map_contains(const map m, const void *key) {
+  return find_slot(m, key) >= 0;
+}
+
+/**
+ * Get the value stored for `key` in `m`, or NULL if there is none.
+ */
+void *map_get(const map m, const void *key) {
+  int i = find_slot(m, key);
+  return i < 0 ? NULL : m->slots[i].value;
+}
+
+/**
+ * Store `value` for `key` in `m`, replacing any existing entry for an equal
+ * key. Returns the value that was replaced, or NULL if there was none.
+ */
+void *map_put(map m, void *key, void *value) {
+  int i = find_slot(m, key);
+  if (i >= 0) {
+    void *old = m->slots[i].value;
+    m->slots[i].value = value;
+    return old;
+  }
+
+  // Keep the load factor at or below 7/8; beyond that, probe sequences start
+  // to get long even with Robin Hood displacement.
+  if ((m->size + 1) * 8 > m->capacity * 7) grow(m);
+  insert_new(m, key, value);
+  m->size += 1;
+  return NULL;
+}
+
+/**
+ * Remove the entry for `key` from `m`, returning its value (or NULL if there
+ * was no such entry).
+ */
+void *map_remove(map m, const void *key) {
+  int i = find_slot(m, key);
+  if (i < 0) return NULL;
+  void *result = m->slots[i].value;
+
+  // Backward-shift deletion: pull each following displaced entry one slot
+  // closer to home, until we hit an empty slot or an entry already at home.
+  // This avoids tombstones, so lookups never have to skip dead slots.
+  int mask = m->capacity - 1;
+  int next = (i + 1) & mask;
+  while (m->dists[next] > 1) {
+    m->slots[i] = m->slots[next];
+    m->dists[i] = m->dists[next] < MAX_DIST ? m->dists[next] - 1 :
+        slot_dist(m, i);
+    i = next;
+    next = (next + 1) & mask;
+  }
+  m->dists[i] = 0;
+  m->size -= 1;
+
+  return result;
+}
+
+/**
+ * Ready-made hash and equality functions for NUL-terminated string keys.
+ */
+uint64_t map_hash_string(const void *key) {
+
+  // FNV-1a; the result is mixed again before use, so it needn't be strong.
+  uint64_t h = 14695981039346656037u;
+  for (const unsigned char *s = key; *s != '\0'; s += 1) {
+    h = (h ^ *s) * 1099511628211u;
+  }
+  return h;
+}
+
+bool map_equal_string(const void *a, const void *b) {
+  return strcmp(a, b) == 0;
+}
+
+/**
+ * Ready-made hash and equality functions that use the key pointers themselves
+ * (so integers cast to `void *` can also be used as keys).
+ */
+uint64_t map_hash_pointer(const void *key) {
+  return (uint64_t) (uintptr_t) key;
+}
+
+bool map_equal_pointer(const void *a, const void *b) {
+  return a == b;
+}
+
+/**
+ * Internal helper; computes the home slot for `key`. The client's hash is
+ * mixed with a Fibonacci multiply so that weak hashes (like raw pointers) still
+ * spread evenly over the table.
+ */
+static int home_slot(const map m, const void *key) {
+  return (int) ((m->hash(key) * 11400714819323198485u) >> m->shift);
+}
+
+/**
+ * Internal helper; finds the slot index holding `key`, or -1 if absent.
+ */
+static int find_slot(const map m, const void *key) {
+  int mask = m->capacity - 1;
+  int i = home_slot(m, key);
+
+  // Walk the probe sequence. Robin Hood ordering guarantees that once we reach
+  // a slot whose entry is closer to home than we are, the key can't be further
+  // along, so misses terminate early.
+  for (int dist = 1; dist <= m->dists[i]; dist += dist < MAX_DIST) {
+    if (m->dists[i] == dist && m->equal(m->slots[i].key, key)) return i;
+    i = (i + 1) & mask;
+  }
+  return -1;
+}
+
+/**
+ * Internal helper; computes the control byte for the entry in slot `i`, from
+ * its key's home slot. Needed only where the stored one has saturated.
+ */
+static int slot_dist(const map m, int i) {
+  int dist = ((i - home_slot(m, m->slots[i].key)) & (m->capacity - 1)) + 1;
+  return dist < MAX_DIST ? dist : MAX_DIST;
+}
+
+/**
+ * Internal helper; inserts an entry known not to be present in `m` already.
+ * Does not update `size`.
+ */
+static void insert_new(map m, void *key, void *value) {
+  int mask = m->capacity - 1;
+  int i = home_slot(m, key);
+  struct slot carry = { key, value };
+  int dist = 1;
+
+  while (m->dists[i] != 0) {
+
+    // Take from the rich: if the resident entry is closer to its home than we
+    // are to ours, it gives up its slot and we carry it onwards instead.
+    if (m->dists[i] < dist) {
+      struct slot displaced = m->slots[i];
+      int displaced_dist = m->dists[i];
+      m->slots[i] = carry;
+      m->dists[i] = dist;
+      carry = displaced;
+      dist = displaced_dist;
+    }
+    i = (i + 1) & mask;
+    if (dist < MAX_DIST) dist += 1;
+  }
+
+  m->slots[i] = carry;
+  m->dists[i] = dist;
+}
+
+/**
+ * Internal helper; replaces the table of `m` with an empty one of `capacity`
+ * slots (a power of two).
+ */
+static void allocate(map m, int capacity) {
+  m->capacity = capacity;
+  m->shift = 64;
+  for (int c = capacity; c > 1; c >>= 1) m->shift -= 1;
+  m->dists = calloc(capacity, sizeof (unsigned char));
+  assert(m->dists != NULL);
+  m->slots = malloc(capacity * sizeof (struct slot));
+  assert(m->slots != NULL);
+}
+
+/**
+ * Internal helper; doubles the table capacity and re-inserts every entry.
+ */
+static void grow(map m) {
+  unsigned char *dists = m->dists;
+  struct slot *slots = m->slots;
+  int capacity = m->capacity;
+
+  // Doubling gives amortized constant time puts, just as for vector pushes.
+  allocate(m, capacity * 2);
+  for (int i = 0; i < capacity; i += 1) {
+    if (dists[i] != 0) insert_new(m, slots[i].key, slots[i].value);
+  }
+
+  free(dists);
+  free(slots);
+}
@@ -0,0 +1,84 @@
+#ifndef __MAP_H
+#define __MAP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Type: Map
+ *
+ * Maintains an unordered association from keys to values, both stored by
+ * reference as `void *` pointers (just like the values in a `vector`). Keys are
+ * hashed and compared using the functions given to `map_create`. Supports
+ * putting, getting and removing values by key in expected constant time.
+ */
+typedef struct map *map;
+
+/**
+ * Hash function for map keys. Equal keys must produce equal hashes.
+ */
+typedef uint64_t (*map_hash_fn)(const void *key);
+
+/**
+ * Equality function for map keys.
+ */
+typedef bool (*map_equal_fn)(const void *a, const void *b);
+
+/**
+ * Create a new, empty map whose keys are hashed with `hash` and compared with
+ * `equal`.
+ *
+ * The returned map will have been dynamically allocated, and must be destroyed
+ * after use using `map_destroy`.
+ */
+map map_create(map_hash_fn hash, map_equal_fn equal);
+
+/**
+ * Clean up a map after use.
+ *
+ * Like `vector_destroy`, this frees only the map's own storage, and not the
+ * keys or values that it references.
+ */
+void map_destroy(map m);
+
+/**
+ * Get the number of entries stored in `m`.
+ */
+int map_size(const map m);
+
+/**
+ * Determine whether `m` contains an entry for `key`.
+ */
+bool map_contains(const map m, const void *key);
+
+/**
+ * Get the value stored for `key` in `m`, or NULL if there is none.
+ */
+void *map_get(const map m, const void *key);
+
+/**
+ * Store `value` for `key` in `m`, replacing any existing entry for an equal
+ * key. Returns the value that was replaced, or NULL if there was none.
+ */
+void *map_put(map m, void *key, void *value);
+
+/**
+ * Remove the entry for `key` from `m`, returning its value (or NULL if there
+ * was no such entry).
+ */
+void *map_remove(map m, const void *key);
+
+/**
+ * Ready-made hash and equality functions for NUL-terminated string keys.
+ */
+uint64_t map_hash_string(const void *key);
+bool map_equal_string(const void *a, const void *b);
+
+/**
+ * Ready-made hash and equality functions that use the key pointers themselves
+ * (so integers cast to `void *` can also be used as keys).
+ */
+uint64_t map_hash_pointer(const void *key);
+bool map_equal_pointer(const void *a, const void *b);
+
+#endif
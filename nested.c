@@ -0,0 +1,182 @@
+#include "nested.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+/**
+ * Struct: Nested Vector
+ *
+ * Implements the storage for the nested vector type defined in `nested.h`.
+ * While building, pushes are recorded as two parallel arrays, in push order:
+ *  `owners`   The row each pushed value belongs to.
+ *  `values`   The pushed values themselves.
+ * This costs two array appends per push, rather than an allocation per row.
+ * Freezing sorts the values by row into their final order in place of
+ * `values`, and fills in:
+ *  `offsets`  For each row, the index into `values` of its first value; there
+ *             is one extra entry at the end holding the total count.
+ * Throughout, `counts` holds the number of values in each row.
+ */
+struct nested {
+  int *counts;
+  int *offsets;
+  int *owners;
+  void **values;
+  int rows;
+  int row_capacity;
+  int size;
+  int capacity;
+  bool frozen;
+};
+
+/**
+ * Create a new, empty nested vector, ready for building.
+ *
+ * The returned nested vector will have been dynamically allocated, and must be
+ * destroyed after use using `nested_destroy`.
+ */
+nested nested_create() {
+  nested n = malloc(sizeof (struct nested));
+  assert(n != NULL);
+  n->counts = malloc(sizeof (int));
+  assert(n->counts != NULL);
+  n->owners = malloc(sizeof (int));
+  assert(n->owners != NULL);
+  n->values = malloc(sizeof (void *));
+  assert(n->values != NULL);
+  n->offsets = NULL;
+  n->rows = 0;
+  n->row_capacity = 1;
+  n->size = 0;
+  n->capacity = 1;
+  n->frozen = false;
+  return n;
+}
+
+/**
+ * Clean up a nested vector after use.
+ *
+ * Like `vector_destroy`, this frees only the nested vector's own storage, and
+ * not the values that it references.
+ */
+void nested_destroy(nested n) {
+  free(n->counts);
+  free(n->offsets);
+  free(n->owners);
+  free(n->values);
+  free(n);
+}
+
+/**
+ * Get the number of rows in `n`.
+ */
+int nested_rows(const nested n) {
+  return n->rows;
+}
+
+/**
+ * Get the number of values in row `row` of `n`.
+ */
+int nested_row_size(const nested n, int row) {
+  assert(row < (size_t) n->rows);
+  return n->counts[row];
+}
+
+/**
+ * Add a new, empty row to the end of `n`, which must not yet be frozen, and
+ * return its index.
+ */
+int nested_add_row(nested n) {
+  assert(!n->frozen);
+  if (n->rows == n->row_capacity) {
+    n->row_capacity *= 2;
+    n->counts = realloc(n->counts, n->row_capacity * sizeof (int));
+    assert(n->counts != NULL);
+  }
+  n->counts[n->rows] = 0;
+  n->rows += 1;
+  return n->rows - 1;
+}
+
+/**
+ * Push `value` onto the end of row `row` of `n`, which must not yet be frozen.
+ */
+void nested_push(nested n, int row, void *value) {
+  assert(!n->frozen);
+  assert(row < (size_t) n->rows);
+  if (n->size == n->capacity) {
+    n->capacity *= 2;
+    n->owners = realloc(n->owners, n->capacity * sizeof (int));
+    assert(n->owners != NULL);
+    n->values = realloc(n->values, n->capacity * sizeof (void *));
+    assert(n->values != NULL);
+  }
+  n->owners[n->size] = row;
+  n->values[n->size] = value;
+  n->size += 1;
+  n->counts[row] += 1;
+}
+
+/**
+ * Finish building `n`, laying out its values in compressed sparse row form.
+ * After this, no more rows or values may be added.
+ */
+void nested_freeze(nested n) {
+  assert(!n->frozen);
+
+  // The row sizes are already known, so the offsets are just their running
+  // sums.
+  n->offsets = malloc((n->rows + 1) * sizeof (int));
+  assert(n->offsets != NULL);
+  n->offsets[0] = 0;
+  for (int row = 0; row < n->rows; row += 1) {
+    n->offsets[row + 1] = n->offsets[row] + n->counts[row];
+  }
+
+  // Then a single counting-sort pass drops every value into its row's next
+  // free position. This is stable, so each row keeps its push order.
+  void **sorted = malloc((n->size > 0 ? n->size : 1) * sizeof (void *));
+  assert(sorted != NULL);
+  int *next = malloc((n->rows > 0 ? n->rows : 1) * sizeof (int));
+  assert(next != NULL);
+  memcpy(next, n->offsets, n->rows * sizeof (int));
+  for (int i = 0; i < n->size; i += 1) {
+    int row = n->owners[i];
+    sorted[next[row]] = n->values[i];
+    next[row] += 1;
+  }
+  free(next);
+
+  // The build-time arrays are no longer needed.
+  free(n->owners);
+  free(n->values);
+  n->owners = NULL;
+  n->values = sorted;
+  n->frozen = true;
+}
+
+/**
+ * Determine whether `n` has been frozen.
+ */
+bool nested_frozen(const nested n) {
+  return n->frozen;
+}
+
+/**
+ * Get the value at index `i` of row `row` in `n`, which must be frozen.
+ */
+void *nested_get(const nested n, int row, int i) {
+  assert(i < (size_t) nested_row_size(n, row));
+  return nested_row(n, row)[i];
+}
+
+/**
+ * Get a pointer to the contiguous array of values in row `row` of `n`, which
+ * must be frozen. The array holds `nested_row_size(n, row)` values.
+ */
+void *const *nested_row(const nested n, int row) {
+  assert(n->frozen);
+  assert(row < (size_t) n->rows);
+  return &n->values[n->offsets[row]];
+}
@@ -0,0 +1,79 @@
+#ifndef __NESTED_H
+#define __NESTED_H
+
+#include <stdbool.h>
+
+/**
+ * Type: Nested Vector
+ *
+ * Maintains a list of rows, each of which is itself a list of values, such as
+ * the adjacency lists of a graph. A nested vector has two phases. While
+ * building, rows are added and values pushed onto any row in any order. Once
+ * `nested_freeze` is called, the nested vector becomes read-only and is laid
+ * out in compressed sparse row form: one contiguous array of all values, row
+ * after row, plus an array of row offsets into it. Reading rows is then a scan
+ * over contiguous memory, instead of a jump to a separately allocated array
+ * per row as with a `vector` of `vector`s.
+ */
+typedef struct nested *nested;
+
+/**
+ * Create a new, empty nested vector, ready for building.
+ *
+ * The returned nested vector will have been dynamically allocated, and must be
+ * destroyed after use using `nested_destroy`.
+ */
+nested nested_create();
+
+/**
+ * Clean up a nested vector after use.
+ *
+ * Like `vector_destroy`, this frees only the nested vector's own storage, and
+ * not the values that it references.
+ */
+void nested_destroy(nested n);
+
+/**
+ * Get the number of rows in `n`.
+ */
+int nested_rows(const nested n);
+
+/**
+ * Get the number of values in row `row` of `n`.
+ */
+int nested_row_size(const nested n, int row);
+
+/**
+ * Add a new, empty row to the end of `n`, which must not yet be frozen, and
+ * return its index.
+ */
+int nested_add_row(nested n);
+
+/**
+ * Push `value` onto the end of row `row` of `n`, which must not yet be frozen.
+ */
+void nested_push(nested n, int row, void *value);
+
+/**
+ * Finish building `n`, laying out its values in compressed sparse row form.
+ * After this, no more rows or values may be added.
+ */
+void nested_freeze(nested n);
+
+/**
+ * Determine whether `n` has been frozen.
+ */
+bool nested_frozen(const nested n);
+
+/**
+ * Get the value at index `i` of row `row` in `n`, which must be frozen.
+ */
+void *nested_get(const nested n, int row, int i);
+
+/**
+ * Get a pointer to the contiguous array of values in row `row` of `n`, which
+ * must be frozen. The array holds `nested_row_size(n, row)` values.
+ */
+void *const *nested_row(const nested n, int row);
+
+#endif
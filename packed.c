@@ -0,0 +1,228 @@
+#include "packed.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <assert.h>
+
+/**
+ * Struct: Packed Vector
+ *
+ * Implements the storage for the packed vector type defined in `packed.h`.
+ * Every full block of `BLOCK` values is described by a `struct block`:
+ *  `base`     The smallest value in the block; values are stored as offsets
+ *             from it.
+ *  `offset`   Index into `data` of the block's first word.
+ *  `width`    Number of bits used for each offset, from 0 to 64. The block
+ *             occupies exactly `2 * width` words of `data`.
+ *
+ * The packed vector itself uses these members:
+ *  `blocks`   Array of blocks, in order.
+ *  `data`     Bit-packed offsets of all blocks, back to back.
+ *  `tail`     The last, partial block, stored uncompressed until it fills up.
+ *  `size`     Number of values currently stored.
+ * along with the capacities of the `blocks` and `data` arrays.
+ */
+#define BLOCK 128
+
+struct block {
+  uint64_t base;
+  int offset;
+  int width;
+};
+
+struct packed {
+  struct block *blocks;
+  int block_capacity;
+  uint64_t *data;
+  int data_capacity;
+  int data_size;
+  uint64_t tail[BLOCK];
+  int size;
+};
+
+// Internal helper functions. Implemented at the bottom of this file.
+static uint64_t unpack(const packed p, const struct block *b, int j);
+static void flush_tail(packed p);
+
+/**
+ * Create a new, empty packed vector.
+ *
+ * The returned packed vector will have been dynamically allocated, and must be
+ * destroyed after use using `packed_destroy`.
+ */
+packed packed_create() {
+  packed p = malloc(sizeof (struct packed));
+  assert(p != NULL);
+  p->blocks = malloc(sizeof (struct block));
+  assert(p->blocks != NULL);
+  p->block_capacity = 1;
+  p->data = malloc(sizeof (uint64_t));
+  assert(p->data != NULL);
+  p->data_capacity = 1;
+  p->data_size = 0;
+  p->size = 0;
+  return p;
+}
+
+/**
+ * Clean up a packed vector after use.
+ */
+void packed_destroy(packed p) {
+  free(p->blocks);
+  free(p->data);
+  free(p);
+}
+
+/**
+ * Get the size (number of values stored) of `p`.
+ */
+int packed_size(const packed p) {
+  return p->size;
+}
+
+/**
+ * Determine whether `i` is a valid index within `p`.
+ */
+bool packed_in_bounds(const packed p, int i) {
+  return i < (size_t) p->size;
+}
+
+/**
+ * Get the value at index `i` in `p`.
+ */
+uint64_t packed_get(const packed p, int i) {
+  assert(i < (size_t) p->size);
+
+  // Values past the last full block are still in the uncompressed tail.
+  int block = i / BLOCK;
+  if (block == p->size / BLOCK) return p->tail[i % BLOCK];
+  return unpack(p, &p->blocks[block], i % BLOCK);
+}
+
+/**
+ * Push `value` onto the end of the packed vector `p`.
+ */
+void packed_push(packed p, uint64_t value) {
+  p->tail[p->size % BLOCK] = value;
+  p->size += 1;
+  if (p->size % BLOCK == 0) flush_tail(p);
+}
+
+/**
+ * Decode the `n` values of `p` starting at index `start` into the array `out`.
+ * This is much faster than calling `packed_get` for each value in turn.
+ */
+void packed_decode(const packed p, int start, int n, uint64_t *out) {
+  assert(start >= 0 && n >= 0 && start + n <= p->size);
+  int full = p->size / BLOCK;
+  int i = start;
+  int end = start + n;
+
+  while (i < end) {
+    int block = i / BLOCK;
+    int j = i % BLOCK;
+    int stop = end - block * BLOCK < BLOCK ? end - block * BLOCK : BLOCK;
+
+    // The tail is a plain copy.
+    if (block == full) {
+      memcpy(out, &p->tail[j], (stop - j) * sizeof (uint64_t));
+      out += stop - j;
+      i += stop - j;
+      continue;
+    }
+
+    // Within a block, walk the packed bits sequentially rather than
+    // recomputing each value's position from scratch.
+    const struct block *b = &p->blocks[block];
+    const uint64_t *words = &p->data[b->offset];
+    int width = b->width;
+    uint64_t mask = width == 64 ? ~(uint64_t) 0 : ((uint64_t) 1 << width) - 1;
+    for (; j < stop; j += 1) {
+      uint64_t value = 0;
+      if (width != 0) {
+        int bit = j * width;
+        int shift = bit % 64;
+        value = words[bit / 64] >> shift;
+        if (shift + width > 64) value |= words[bit / 64 + 1] << (64 - shift);
+      }
+      *out = b->base + (value & mask);
+      out += 1;
+      i += 1;
+    }
+  }
+}
+
+/**
+ * Get the number of bytes of storage used by `p`'s values.
+ */
+long packed_bytes(const packed p) {
+  return (long) p->data_size * sizeof (uint64_t) +
+      (long) (p->size / BLOCK) * sizeof (struct block) + sizeof p->tail;
+}
+
+/**
+ * Internal helper; reads the value at position `j` within the full block `b`.
+ */
+static uint64_t unpack(const packed p, const struct block *b, int j) {
+  if (b->width == 0) return b->base;
+
+  // A value may straddle two words.
+  const uint64_t *words = &p->data[b->offset];
+  int bit = j * b->width;
+  int shift = bit % 64;
+  uint64_t value = words[bit / 64] >> shift;
+  if (shift + b->width > 64) value |= words[bit / 64 + 1] << (64 - shift);
+  if (b->width < 64) value &= ((uint64_t) 1 << b->width) - 1;
+  return b->base + value;
+}
+
+/**
+ * Internal helper; compresses the (just filled) tail into a new full block.
+ */
+static void flush_tail(packed p) {
+
+  // The block's frame of reference is its minimum, and its width is just
+  // enough bits for the largest offset from there.
+  uint64_t min = p->tail[0];
+  uint64_t max = p->tail[0];
+  for (int j = 1; j < BLOCK; j += 1) {
+    if (p->tail[j] < min) min = p->tail[j];
+    if (p->tail[j] > max) max = p->tail[j];
+  }
+  int width = max == min ? 0 : 64 - __builtin_clzll(max - min);
+
+  // Make room for the block and its `BLOCK * width / 64` words, doubling the
+  // arrays as necessary.
+  int index = p->size / BLOCK - 1;
+  if (index == p->block_capacity) {
+    p->block_capacity *= 2;
+    p->blocks = realloc(p->blocks, p->block_capacity * sizeof (struct block));
+    assert(p->blocks != NULL);
+  }
+  int words = BLOCK * width / 64;
+  if (p->data_size + words > p->data_capacity) {
+    while (p->data_size + words > p->data_capacity) p->data_capacity *= 2;
+    p->data = realloc(p->data, p->data_capacity * sizeof (uint64_t));
+    assert(p->data != NULL);
+  }
+
+  struct block *b = &p->blocks[index];
+  b->base = min;
+  b->offset = p->data_size;
+  b->width = width;
+  p->data_size += words;
+
+  // Pack each offset into the zeroed words, splitting it across two words
+  // when it straddles a boundary.
+  uint64_t *out = &p->data[b->offset];
+  memset(out, 0, words * sizeof (uint64_t));
+  if (width == 0) return;
+  for (int j = 0; j < BLOCK; j += 1) {
+    uint64_t value = p->tail[j] - min;
+    int bit = j * width;
+    int shift = bit % 64;
+    out[bit / 64] |= value << shift;
+    if (shift + width > 64) out[bit / 64 + 1] |= value >> (64 - shift);
+  }
+}
@@ -0,0 +1,64 @@
+#ifndef __PACKED_H
+#define __PACKED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Type: Packed Vector
+ *
+ * Maintains an append-only list of unsigned integers in compressed form.
+ * Values are grouped into blocks of 128, and each block is stored relative to
+ * its smallest value using only as many bits per value as the block's range
+ * needs (frame-of-reference bit packing). Lists of nearby values, such as
+ * sorted IDs, take a small fraction of the 8 bytes per value that storing them
+ * in a `vector` would, while any single value can still be read in constant
+ * time without decoding the rest of its block.
+ */
+typedef struct packed *packed;
+
+/**
+ * Create a new, empty packed vector.
+ *
+ * The returned packed vector will have been dynamically allocated, and must be
+ * destroyed after use using `packed_destroy`.
+ */
+packed packed_create();
+
+/**
+ * Clean up a packed vector after use.
+ */
+void packed_destroy(packed p);
+
+/**
+ * Get the size (number of values stored) of `p`.
+ */
+int packed_size(const packed p);
+
+/**
+ * Determine whether `i` is a valid index within `p`.
+ */
+bool packed_in_bounds(const packed p, int i);
+
+/**
+ * Get the value at index `i` in `p`.
+ */
+uint64_t packed_get(const packed p, int i);
+
+/**
+ * Push `value` onto the end of the packed vector `p`.
+ */
+void packed_push(packed p, uint64_t value);
+
+/**
+ * Decode the `n` values of `p` starting at index `start` into the array `out`.
+ * This is much faster than calling `packed_get` for each value in turn.
+ */
+void packed_decode(const packed p, int start, int n, uint64_t *out);
+
+/**
+ * Get the number of bytes of storage used by `p`'s values.
+ */
+long packed_bytes(const packed p);
+
+#endif
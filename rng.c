@@ -0,0 +1,100 @@
+#include "rng.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+
+/**
+ * Struct: Random Number Generator
+ *
+ * Implements the state for the generator type defined in `rng.h`: the 256 bits
+ * of xoshiro256** state, as four words.
+ */
+struct rng {
+  uint64_t s[4];
+};
+
+// Internal helper function. Implemented at the bottom of this file.
+static uint64_t rotl(uint64_t x, int k);
+
+/**
+ * Create a new random number generator from `seed`. Generators created from
+ * the same seed produce the same sequence of numbers.
+ *
+ * The returned generator will have been dynamically allocated, and must be
+ * destroyed after use using `rng_destroy`.
+ */
+rng rng_create(uint64_t seed) {
+  rng r = malloc(sizeof (struct rng));
+  assert(r != NULL);
+
+  // Expand the seed into the full state with splitmix64, which guarantees the
+  // state is never all zero (from which xoshiro would never escape).
+  for (int i = 0; i < 4; i += 1) {
+    seed += 0x9e3779b97f4a7c15;
+    uint64_t z = seed;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    r->s[i] = z ^ (z >> 31);
+  }
+  return r;
+}
+
+/**
+ * Clean up a random number generator after use.
+ */
+void rng_destroy(rng r) {
+  free(r);
+}
+
+/**
+ * Get the next uniformly distributed 64-bit number from `r`.
+ */
+uint64_t rng_next(rng r) {
+  uint64_t *s = r->s;
+  uint64_t result = rotl(s[1] * 5, 7) * 9;
+  uint64_t t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl(s[3], 45);
+  return result;
+}
+
+/**
+ * Get a uniformly distributed number from `r` in the range [0, `bound`).
+ * `bound` must not be zero.
+ */
+uint64_t rng_below(rng r, uint64_t bound) {
+  assert(bound != 0);
+
+  // Lemire's method: take the high word of a 128-bit product, which avoids a
+  // division in almost every call, and reject the rare biased low words.
+  unsigned __int128 m = (unsigned __int128) rng_next(r) * bound;
+  uint64_t low = (uint64_t) m;
+  if (low < bound) {
+    uint64_t threshold = -bound % bound;
+    while (low < threshold) {
+      m = (unsigned __int128) rng_next(r) * bound;
+      low = (uint64_t) m;
+    }
+  }
+  return (uint64_t) (m >> 64);
+}
+
+/**
+ * Get a uniformly distributed number from `r` in the range [0, 1).
+ */
+double rng_double(rng r) {
+
+  // The top 53 bits fill a double's mantissa exactly.
+  return (rng_next(r) >> 11) * 0x1.0p-53;
+}
+
+/**
+ * Internal helper; rotates `x` left by `k` bits.
+ */
+static uint64_t rotl(uint64_t x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
@@ -0,0 +1,45 @@
+#ifndef __RNG_H
+#define __RNG_H
+
+#include <stdint.h>
+
+/**
+ * Type: Random Number Generator
+ *
+ * A fast, seedable pseudo-random number generator (xoshiro256**), for use with
+ * the randomized vector operations such as `vector_shuffle`. It is not
+ * suitable for cryptographic purposes.
+ */
+typedef struct rng *rng;
+
+/**
+ * Create a new random number generator from `seed`. Generators created from
+ * the same seed produce the same sequence of numbers.
+ *
+ * The returned generator will have been dynamically allocated, and must be
+ * destroyed after use using `rng_destroy`.
+ */
+rng rng_create(uint64_t seed);
+
+/**
+ * Clean up a random number generator after use.
+ */
+void rng_destroy(rng r);
+
+/**
+ * Get the next uniformly distributed 64-bit number from `r`.
+ */
+uint64_t rng_next(rng r);
+
+/**
+ * Get a uniformly distributed number from `r` in the range [0, `bound`).
+ * `bound` must not be zero.
+ */
+uint64_t rng_below(rng r, uint64_t bound);
+
+/**
+ * Get a uniformly distributed number from `r` in the range [0, 1).
+ */
+double rng_double(rng r);
+
+#endif
@@ -0,0 +1,418 @@
+#include "rope.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+/**
+ * Struct: Rope
+ *
+ * Implements the storage for the rope type defined in `rope.h`. Elements are
+ * kept in fixed-size chunks, and the chunks are the nodes of a treap: a binary
+ * search tree ordered by position, balanced by giving each node a random
+ * `priority` that must not exceed its parent's. Each node uses these members:
+ *  `elems`    The node's own chunk of elements, in order.
+ *  `length`   Number of elements in `elems`.
+ *  `count`    Number of elements in the whole subtree rooted at this node;
+ *             this is what lets us find an index in logarithmic time.
+ *  `left`     Subtree holding the elements before this chunk.
+ *  `right`    Subtree holding the elements after this chunk.
+ *
+ * The rope itself just holds the root node and the state of the generator
+ * used to pick priorities.
+ */
+#define CHUNK 64
+
+struct node {
+  struct node *left;
+  struct node *right;
+  unsigned priority;
+  int count;
+  int length;
+  void *elems[CHUNK];
+};
+
+struct rope {
+  struct node *root;
+  unsigned seed;
+};
+
+// Internal helper functions. Implemented at the bottom of this file.
+static struct node *make_node(rope r);
+static void update(struct node *n);
+static struct node *merge(struct node *a, struct node *b);
+static void split(rope r, struct node *n, int k, struct node **left,
+    struct node **right);
+static void **get_element(const rope r, int i);
+static void *remove_at(struct node **slot, int i);
+static void flatten_tree(const struct node *n, vector v);
+static void destroy_tree(struct node *n);
+
+/**
+ * Create a new, empty rope.
+ *
+ * The returned rope will have been dynamically allocated, and must be
+ * destroyed after use using `rope_destroy`.
+ */
+rope rope_create() {
+  rope r = malloc(sizeof (struct rope));
+  assert(r != NULL);
+  r->root = NULL;
+  r->seed = 2463534242u;
+  return r;
+}
+
+/**
+ * Clean up a rope after use.
+ *
+ * Like `vector_destroy`, this frees only the rope's own storage, and not the
+ * values that it references.
+ */
+void rope_destroy(rope r) {
+  destroy_tree(r->root);
+  free(r);
+}
+
+/**
+ * Get the size (number of elements stored) of `r`.
+ */
+int rope_size(const rope r) {
+  return r->root == NULL ? 0 : r->root->count;
+}
+
+/**
+ * Determine whether `i` is a valid index within `r`.
+ */
+bool rope_in_bounds(const rope r, int i) {
+  return i < (size_t) rope_size(r);
+}
+
+/**
+ * Write `value` at the existing index `i` in the rope `r`.
+ */
+void rope_set(rope r, int i, void *value) {
+  *get_element(r, i) = value;
+}
+
+/**
+ * Get the value at index `i` in `r`.
+ */
+void *rope_get(const rope r, int i) {
+  return *get_element(r, i);
+}
+
+/**
+ * Insert `value` at index `i` in the rope `r`, shifting all existing elements
+ * starting at index `i` one position to the right.
+ */
+void rope_insert(rope r, int i, void *value) {
+  assert(i <= (size_t) rope_size(r));
+
+  // An empty rope just gets a single chunk.
+  if (r->root == NULL) {
+    r->root = make_node(r);
+  }
+
+  // Find the chunk that spans position `i` (preferring the earlier chunk when
+  // `i` falls on a boundary), keeping track of where it starts.
+  struct node *n = r->root;
+  int start = 0;
+  while (true) {
+    int left = n->left == NULL ? 0 : n->left->count;
+    if (i - start < left) {
+      n = n->left;
+    } else if (i - start > left + n->length) {
+      start += left + n->length;
+      n = n->right;
+    } else {
+      start += left;
+      break;
+    }
+  }
+
+  // A full chunk is split down the middle by splitting and re-merging the whole
+  // tree there, after which one half is sure to have room; then we retry.
+  if (n->length == CHUNK) {
+    struct node *a, *b;
+    split(r, r->root, start + CHUNK / 2, &a, &b);
+    r->root = merge(a, b);
+    rope_insert(r, i, value);
+    return;
+  }
+
+  // Otherwise, shift the tail of this chunk to make room, and bump the counts
+  // along the path from the root.
+  int offset = i - start;
+  memmove(&n->elems[offset + 1], &n->elems[offset],
+      (n->length - offset) * sizeof (void *));
+  n->elems[offset] = value;
+  n->length += 1;
+  for (struct node *p = r->root; p != n; ) {
+    int left = p->left == NULL ? 0 : p->left->count;
+    p->count += 1;
+    if (i < left) {
+      p = p->left;
+    } else {
+      i -= left + p->length;
+      p = p->right;
+    }
+  }
+  n->count += 1;
+}
+
+/**
+ * Remove and return the value at index `i` of the rope `r`.
+ */
+void *rope_remove(rope r, int i) {
+  assert(i < (size_t) rope_size(r));
+  return remove_at(&r->root, i);
+}
+
+/**
+ * Push `value` onto the end of the rope `r`.
+ */
+void rope_push(rope r, void *value) {
+  rope_insert(r, rope_size(r), value);
+}
+
+/**
+ * Remove and return the value at the end of the rope `r`.
+ */
+void *rope_pop(rope r) {
+  return rope_remove(r, rope_size(r) - 1);
+}
+
+/**
+ * Create a new rope holding the same values as the vector `v`, in order.
+ *
+ * The returned rope must be destroyed after use using `rope_destroy`.
+ */
+rope rope_from_vector(const vector v) {
+  rope r = rope_create();
+
+  // Fill whole chunks at a time, and merge each onto the right end of the
+  // tree, rather than inserting values one by one.
+  int size = vector_size(v);
+  for (int i = 0; i < size; i += CHUNK) {
+    struct node *n = make_node(r);
+    n->length = size - i < CHUNK ? size - i : CHUNK;
+    for (int j = 0; j < n->length; j += 1) {
+      n->elems[j] = vector_get(v, i + j);
+    }
+    update(n);
+    r->root = merge(r->root, n);
+  }
+  return r;
+}
+
+/**
+ * Create a new vector holding the values of `r`, in order, in one contiguous
+ * array that is fast to scan.
+ *
+ * The returned vector must be destroyed after use using `vector_destroy`.
+ */
+vector rope_flatten(const rope r) {
+  vector v = vector_create();
+  flatten_tree(r->root, v);
+  return v;
+}
+
+/**
+ * Append all the values of `other` to the end of `r`, in *O*(log *n*) time.
+ * Afterwards, `other` is left empty (but must still be destroyed).
+ */
+void rope_concat(rope r, rope other) {
+  r->root = merge(r->root, other->root);
+  other->root = NULL;
+}
+
+/**
+ * Split `r` at index `i`, in *O*(log *n*) time. `r` keeps the values before
+ * index `i`, and the values from index `i` onwards are moved into a new rope,
+ * which is returned and must be destroyed after use using `rope_destroy`.
+ */
+rope rope_split_at(rope r, int i) {
+  assert(i >= 0 && i <= rope_size(r));
+  rope tail = rope_create();
+  split(r, r->root, i, &r->root, &tail->root);
+  return tail;
+}
+
+/**
+ * Replace the `n` values of `r` starting at index `i` with all the values of
+ * `other`, in *O*(log *n*) time. Afterwards, `other` is left empty, and the
+ * removed values are returned in a new rope, which must be destroyed after use
+ * using `rope_destroy`.
+ */
+rope rope_splice(rope r, int i, int n, rope other) {
+  assert(i >= 0 && n >= 0 && i + n <= rope_size(r));
+
+  // Cut out the middle section, then stitch the new section into its place.
+  rope removed = rope_split_at(r, i);
+  rope tail = rope_split_at(removed, n);
+  rope_concat(r, other);
+  rope_concat(r, tail);
+  rope_destroy(tail);
+  return removed;
+}
+
+/**
+ * Internal helper; allocates a new, empty, unlinked node with a fresh random
+ * priority.
+ */
+static struct node *make_node(rope r) {
+  struct node *n = malloc(sizeof (struct node));
+  assert(n != NULL);
+
+  // Xorshift is plenty random enough to keep the treap balanced.
+  r->seed ^= r->seed << 13;
+  r->seed ^= r->seed >> 17;
+  r->seed ^= r->seed << 5;
+  n->priority = r->seed;
+
+  n->left = NULL;
+  n->right = NULL;
+  n->count = 0;
+  n->length = 0;
+  return n;
+}
+
+/**
+ * Internal helper; recomputes the subtree count of `n` from its children.
+ */
+static void update(struct node *n) {
+  n->count = n->length;
+  if (n->left != NULL) n->count += n->left->count;
+  if (n->right != NULL) n->count += n->right->count;
+}
+
+/**
+ * Internal helper; joins two trees, where every element of `a` comes before
+ * every element of `b`.
+ */
+static struct node *merge(struct node *a, struct node *b) {
+  if (a == NULL) return b;
+  if (b == NULL) return a;
+  if (a->priority >= b->priority) {
+    a->right = merge(a->right, b);
+    update(a);
+    return a;
+  } else {
+    b->left = merge(a, b->left);
+    update(b);
+    return b;
+  }
+}
+
+/**
+ * Internal helper; splits the tree `n` into `left`, holding its first `k`
+ * elements, and `right`, holding the rest. If the split point falls inside a
+ * chunk, that chunk is itself divided in two.
+ */
+static void split(rope r, struct node *n, int k, struct node **left,
+    struct node **right) {
+  if (n == NULL) {
+    *left = NULL;
+    *right = NULL;
+    return;
+  }
+
+  int before = n->left == NULL ? 0 : n->left->count;
+  if (k <= before) {
+    split(r, n->left, k, left, &n->left);
+    update(n);
+    *right = n;
+  } else if (k >= before + n->length) {
+    split(r, n->right, k - before - n->length, &n->right, right);
+    update(n);
+    *left = n;
+  } else {
+
+    // Move the tail of this chunk into a new node, and hand it, together with
+    // our old right subtree, to the right-hand side.
+    int offset = k - before;
+    struct node *tail = make_node(r);
+    tail->length = n->length - offset;
+    memcpy(tail->elems, &n->elems[offset], tail->length * sizeof (void *));
+    update(tail);
+    *right = merge(tail, n->right);
+
+    n->length = offset;
+    n->right = NULL;
+    update(n);
+    *left = n;
+  }
+}
+
+/**
+ * Internal helper; computes a pointer to the memory location for a given index
+ * `i` within `r`.
+ */
+static void **get_element(const rope r, int i) {
+  assert(i < (size_t) rope_size(r));
+  struct node *n = r->root;
+  while (true) {
+    int left = n->left == NULL ? 0 : n->left->count;
+    if (i < left) {
+      n = n->left;
+    } else if (i < left + n->length) {
+      return &n->elems[i - left];
+    } else {
+      i -= left + n->length;
+      n = n->right;
+    }
+  }
+}
+
+/**
+ * Internal helper; removes and returns the element at index `i` within the
+ * subtree stored at `*slot`, unlinking its node if the chunk becomes empty.
+ */
+static void *remove_at(struct node **slot, int i) {
+  struct node *n = *slot;
+  int left = n->left == NULL ? 0 : n->left->count;
+  void *result;
+
+  if (i < left) {
+    result = remove_at(&n->left, i);
+  } else if (i < left + n->length) {
+    int offset = i - left;
+    result = n->elems[offset];
+    memmove(&n->elems[offset], &n->elems[offset + 1],
+        (n->length - offset - 1) * sizeof (void *));
+    n->length -= 1;
+
+    // An emptied chunk is dropped, and its subtrees joined in its place.
+    if (n->length == 0) {
+      *slot = merge(n->left, n->right);
+      free(n);
+      return result;
+    }
+  } else {
+    result = remove_at(&n->right, i - left - n->length);
+  }
+
+  n->count -= 1;
+  return result;
+}
+
+/**
+ * Internal helper; appends the values of the tree `n` to `v`, in order, one
+ * whole chunk at a time.
+ */
+static void flatten_tree(const struct node *n, vector v) {
+  if (n == NULL) return;
+  flatten_tree(n->left, v);
+  vector_push_many(v, n->elems, n->length);
+  flatten_tree(n->right, v);
+}
+
+/**
+ * Internal helper; frees every node in the tree `n`.
+ */
+static void destroy_tree(struct node *n) {
+  if (n == NULL) return;
+  destroy_tree(n->left);
+  destroy_tree(n->right);
+  free(n);
+}
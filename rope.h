@@ -0,0 +1,111 @@
+#ifndef __ROPE_H
+#define __ROPE_H
+
+#include <stdbool.h>
+#include "vector.h"
+
+/**
+ * Type: Rope
+ *
+ * An ordered, variable-length list of values with the same index-based
+ * interface as `vector`, but stored as a balanced tree of small chunks rather
+ * than one contiguous array. Every positional operation (get, set, insert and
+ * remove at any index) runs in *O*(log *n*) time, which makes a rope the better
+ * choice for very large lists that are frequently edited in the middle.
+ */
+typedef struct rope *rope;
+
+/**
+ * Create a new, empty rope.
+ *
+ * The returned rope will have been dynamically allocated, and must be
+ * destroyed after use using `rope_destroy`.
+ */
+rope rope_create();
+
+/**
+ * Clean up a rope after use.
+ *
+ * Like `vector_destroy`, this frees only the rope's own storage, and not the
+ * values that it references.
+ */
+void rope_destroy(rope r);
+
+/**
+ * Get the size (number of elements stored) of `r`.
+ */
+int rope_size(const rope r);
+
+/**
+ * Determine whether `i` is a valid index within `r`.
+ */
+bool rope_in_bounds(const rope r, int i);
+
+/**
+ * Write `value` at the existing index `i` in the rope `r`.
+ */
+void rope_set(rope r, int i, void *value);
+
+/**
+ * Get the value at index `i` in `r`.
+ */
+void *rope_get(const rope r, int i);
+
+/**
+ * Insert `value` at index `i` in the rope `r`, shifting all existing elements
+ * starting at index `i` one position to the right.
+ */
+void rope_insert(rope r, int i, void *value);
+
+/**
+ * Remove and return the value at index `i` of the rope `r`.
+ */
+void *rope_remove(rope r, int i);
+
+/**
+ * Push `value` onto the end of the rope `r`.
+ */
+void rope_push(rope r, void *value);
+
+/**
+ * Remove and return the value at the end of the rope `r`.
+ */
+void *rope_pop(rope r);
+
+/**
+ * Create a new rope holding the same values as the vector `v`, in order.
+ *
+ * The returned rope must be destroyed after use using `rope_destroy`.
+ */
+rope rope_from_vector(const vector v);
+
+/**
+ * Create a new vector holding the values of `r`, in order, in one contiguous
+ * array that is fast to scan.
+ *
+ * The returned vector must be destroyed after use using `vector_destroy`.
+ */
+vector rope_flatten(const rope r);
+
+/**
+ * Append all the values of `other` to the end of `r`, in *O*(log *n*) time.
+ * Afterwards, `other` is left empty (but must still be destroyed).
+ */
+void rope_concat(rope r, rope other);
+
+/**
+ * Split `r` at index `i`, in *O*(log *n*) time. `r` keeps the values before
+ * index `i`, and the values from index `i` onwards are moved into a new rope,
+ * which is returned and must be destroyed after use using `rope_destroy`.
+ */
+rope rope_split_at(rope r, int i);
+
+/**
+ * Replace the `n` values of `r` starting at index `i` with all the values of
+ * `other`, in *O*(log *n*) time. Afterwards, `other` is left empty, and the
+ * removed values are returned in a new rope, which must be destroyed after use
+ * using `rope_destroy`.
+ */
+rope rope_splice(rope r, int i, int n, rope other);
+
+#endif
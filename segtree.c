@@ -0,0 +1,168 @@
+#include "segtree.h"
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+
+/**
+ * Struct: Segment Tree
+ *
+ * Implements the storage for the segment tree type defined in `segtree.h`, as
+ * a flat, bottom-up tree over `n` leaves. Node `k` (for `k` from 1 to `n - 1`)
+ * covers the ranges of its children `2k` and `2k + 1`, and leaf `i` is node
+ * `n + i`. Each node's aggregates are kept in three parallel arrays, `sum`,
+ * `min` and `max`, each of `2n` entries (entry 0 is unused).
+ */
+struct segtree {
+  double *sum;
+  double *min;
+  double *max;
+  int n;
+};
+
+// Internal helper function. Implemented at the bottom of this file.
+static void pull(segtree t, int k);
+
+/**
+ * Create a segment tree over the numbers in the vector `values`, whose values
+ * must each point to a `double`. The numbers are copied, so later changes to
+ * `values` must be forwarded with `segtree_set`.
+ *
+ * The returned segment tree will have been dynamically allocated, and must be
+ * destroyed after use using `segtree_destroy`.
+ */
+segtree segtree_create(const vector values) {
+  segtree t = malloc(sizeof (struct segtree));
+  assert(t != NULL);
+  t->n = vector_size(values);
+  int nodes = t->n > 0 ? 2 * t->n : 1;
+  t->sum = malloc(nodes * sizeof (double));
+  assert(t->sum != NULL);
+  t->min = malloc(nodes * sizeof (double));
+  assert(t->min != NULL);
+  t->max = malloc(nodes * sizeof (double));
+  assert(t->max != NULL);
+
+  // Fill in the leaves, then build every internal node from its children in
+  // a single backwards pass.
+  for (int i = 0; i < t->n; i += 1) {
+    double value = *(const double *) vector_get(values, i);
+    t->sum[t->n + i] = value;
+    t->min[t->n + i] = value;
+    t->max[t->n + i] = value;
+  }
+  for (int k = t->n - 1; k > 0; k -= 1) {
+    pull(t, k);
+  }
+
+  return t;
+}
+
+/**
+ * Clean up a segment tree after use.
+ */
+void segtree_destroy(segtree t) {
+  free(t->sum);
+  free(t->min);
+  free(t->max);
+  free(t);
+}
+
+/**
+ * Get the number of numbers in `t`.
+ */
+int segtree_size(const segtree t) {
+  return t->n;
+}
+
+/**
+ * Write `value` at index `i` in `t`.
+ */
+void segtree_set(segtree t, int i, double value) {
+  assert(i < (size_t) t->n);
+
+  // Update the leaf, then each of its ancestors on the way to the root.
+  int k = t->n + i;
+  t->sum[k] = value;
+  t->min[k] = value;
+  t->max[k] = value;
+  for (k /= 2; k > 0; k /= 2) {
+    pull(t, k);
+  }
+}
+
+/**
+ * Get the number at index `i` in `t`.
+ */
+double segtree_get(const segtree t, int i) {
+  assert(i < (size_t) t->n);
+  return t->sum[t->n + i];
+}
+
+/**
+ * Get the sum, minimum or maximum of the numbers in `t` from index `start` up
+ * to (but not including) index `end`. An empty range has a sum of zero, a
+ * minimum of positive infinity, and a maximum of negative infinity.
+ */
+double segtree_sum(const segtree t, int start, int end) {
+  assert(start >= 0 && start <= end && end <= t->n);
+  double result = 0;
+
+  // Climb from both ends of the range towards the root. Whenever a boundary
+  // node's sibling falls outside the range, the node itself is included
+  // whole, and we step inwards past it.
+  for (int lo = start + t->n, hi = end + t->n; lo < hi; lo /= 2, hi /= 2) {
+    if (lo % 2 == 1) {
+      result += t->sum[lo];
+      lo += 1;
+    }
+    if (hi % 2 == 1) {
+      hi -= 1;
+      result += t->sum[hi];
+    }
+  }
+  return result;
+}
+
+double segtree_min(const segtree t, int start, int end) {
+  assert(start >= 0 && start <= end && end <= t->n);
+  double result = INFINITY;
+  for (int lo = start + t->n, hi = end + t->n; lo < hi; lo /= 2, hi /= 2) {
+    if (lo % 2 == 1) {
+      result = t->min[lo] < result ? t->min[lo] : result;
+      lo += 1;
+    }
+    if (hi % 2 == 1) {
+      hi -= 1;
+      result = t->min[hi] < result ? t->min[hi] : result;
+    }
+  }
+  return result;
+}
+
+double segtree_max(const segtree t, int start, int end) {
+  assert(start >= 0 && start <= end && end <= t->n);
+  double result = -INFINITY;
+  for (int lo = start + t->n, hi = end + t->n; lo < hi; lo /= 2, hi /= 2) {
+    if (lo % 2 == 1) {
+      result = t->max[lo] > result ? t->max[lo] : result;
+      lo += 1;
+    }
+    if (hi % 2 == 1) {
+      hi -= 1;
+      result = t->max[hi] > result ? t->max[hi] : result;
+    }
+  }
+  return result;
+}
+
+/**
+ * Internal helper; recomputes the aggregates of internal node `k` from its
+ * two children.
+ */
+static void pull(segtree t, int k) {
+  t->sum[k] = t->sum[2 * k] + t->sum[2 * k + 1];
+  double *min = &t->min[2 * k];
+  double *max = &t->max[2 * k];
+  t->min[k] = min[0] < min[1] ? min[0] : min[1];
+  t->max[k] = max[0] > max[1] ? max[0] : max[1];
+}
@@ -0,0 +1,54 @@
+#ifndef __SEGTREE_H
+#define __SEGTREE_H
+
+#include "vector.h"
+
+/**
+ * Type: Segment Tree
+ *
+ * A fixed-size list of numbers that answers range queries (the sum, minimum
+ * or maximum of any contiguous range) in *O*(log *n*) time, while still
+ * allowing individual numbers to be updated in *O*(log *n*) time.
+ */
+typedef struct segtree *segtree;
+
+/**
+ * Create a segment tree over the numbers in the vector `values`, whose values
+ * must each point to a `double`. The numbers are copied, so later changes to
+ * `values` must be forwarded with `segtree_set`.
+ *
+ * The returned segment tree will have been dynamically allocated, and must be
+ * destroyed after use using `segtree_destroy`.
+ */
+segtree segtree_create(const vector values);
+
+/**
+ * Clean up a segment tree after use.
+ */
+void segtree_destroy(segtree t);
+
+/**
+ * Get the number of numbers in `t`.
+ */
+int segtree_size(const segtree t);
+
+/**
+ * Write `value` at index `i` in `t`.
+ */
+void segtree_set(segtree t, int i, double value);
+
+/**
+ * Get the number at index `i` in `t`.
+ */
+double segtree_get(const segtree t, int i);
+
+/**
+ * Get the sum, minimum or maximum of the numbers in `t` from index `start` up
+ * to (but not including) index `end`. An empty range has a sum of zero, a
+ * minimum of positive infinity, and a maximum of negative infinity.
+ */
+double segtree_sum(const segtree t, int start, int end);
+double segtree_min(const segtree t, int start, int end);
+double segtree_max(const segtree t, int start, int end);
+
+#endif
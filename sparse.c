@@ -0,0 +1,229 @@
+#include "sparse.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+/**
+ * Struct: Sparse Vector
+ *
+ * Implements the storage for the sparse vector type defined in `sparse.h`.
+ * The non-empty slots are stored as two parallel arrays, sorted by index:
+ *  `indices`  The index of each non-empty slot.
+ *  `values`   The value in each non-empty slot.
+ * Plus some metadata:
+ *  `capacity` Max number of entries the arrays can store without
+ *             reallocating.
+ *  `count`    Number of entries (non-empty slots) currently stored.
+ *  `size`     Number of slots, empty or not.
+ */
+struct sparse {
+  int *indices;
+  void **values;
+  int capacity;
+  int count;
+  int size;
+};
+
+// Internal helper functions. Implemented at the bottom of this file.
+static int find_entry(const sparse s, int i);
+static void add_entry(sparse s, int k, int i, void *value);
+static void remove_entry(sparse s, int k);
+
+/**
+ * Create a new, empty sparse vector.
+ *
+ * The returned sparse vector will have been dynamically allocated, and must be
+ * destroyed after use using `sparse_destroy`.
+ */
+sparse sparse_create() {
+  sparse s = malloc(sizeof (struct sparse));
+  assert(s != NULL);
+  s->indices = malloc(sizeof (int));
+  assert(s->indices != NULL);
+  s->values = malloc(sizeof (void *));
+  assert(s->values != NULL);
+  s->capacity = 1;
+  s->count = 0;
+  s->size = 0;
+  return s;
+}
+
+/**
+ * Clean up a sparse vector after use.
+ *
+ * Like `vector_destroy`, this frees only the sparse vector's own storage, and
+ * not the values that it references.
+ */
+void sparse_destroy(sparse s) {
+  free(s->indices);
+  free(s->values);
+  free(s);
+}
+
+/**
+ * Get the size (number of slots, empty or not) of `s`.
+ */
+int sparse_size(const sparse s) {
+  return s->size;
+}
+
+/**
+ * Determine whether `i` is a valid index within `s`.
+ */
+bool sparse_in_bounds(const sparse s, int i) {
+  return i < (size_t) s->size;
+}
+
+/**
+ * Write `value` at the existing index `i` in `s`. Writing NULL empties the
+ * slot.
+ */
+void sparse_set(sparse s, int i, void *value) {
+  assert(i < (size_t) s->size);
+  int k = find_entry(s, i);
+  bool found = k < s->count && s->indices[k] == i;
+
+  if (found && value == NULL) {
+    remove_entry(s, k);
+  } else if (found) {
+    s->values[k] = value;
+  } else if (value != NULL) {
+    add_entry(s, k, i, value);
+  }
+}
+
+/**
+ * Get the value at index `i` in `s`, or NULL if the slot is empty.
+ */
+void *sparse_get(const sparse s, int i) {
+  assert(i < (size_t) s->size);
+  int k = find_entry(s, i);
+  return k < s->count && s->indices[k] == i ? s->values[k] : NULL;
+}
+
+/**
+ * Insert `value` (which may be NULL) at index `i` in `s`, shifting all
+ * existing slots starting at index `i` one position to the right.
+ */
+void sparse_insert(sparse s, int i, void *value) {
+  assert(i <= (size_t) s->size);
+  s->size += 1;
+
+  // Only the entries at or after `i` need their indices bumped; the empty
+  // slots among them move along for free.
+  int k = find_entry(s, i);
+  for (int j = k; j < s->count; j += 1) {
+    s->indices[j] += 1;
+  }
+  if (value != NULL) add_entry(s, k, i, value);
+}
+
+/**
+ * Remove and return the value (or NULL) at index `i` of `s`.
+ */
+void *sparse_remove(sparse s, int i) {
+  assert(i < (size_t) s->size);
+  int k = find_entry(s, i);
+  void *result = NULL;
+  if (k < s->count && s->indices[k] == i) {
+    result = s->values[k];
+    remove_entry(s, k);
+  }
+
+  // Entries after `i` each move down one slot.
+  for (int j = k; j < s->count; j += 1) {
+    s->indices[j] -= 1;
+  }
+  s->size -= 1;
+
+  return result;
+}
+
+/**
+ * Push `value` (which may be NULL) onto the end of `s`.
+ */
+void sparse_push(sparse s, void *value) {
+  sparse_insert(s, s->size, value);
+}
+
+/**
+ * Remove and return the value (or NULL) at the end of `s`.
+ */
+void *sparse_pop(sparse s) {
+  return sparse_remove(s, s->size - 1);
+}
+
+/**
+ * Get the number of non-empty slots in `s`.
+ */
+int sparse_count(const sparse s) {
+  return s->count;
+}
+
+/**
+ * Get the index of the `k`th non-empty slot in `s`, counting from zero in
+ * index order.
+ */
+int sparse_index_at(const sparse s, int k) {
+  assert(k < (size_t) s->count);
+  return s->indices[k];
+}
+
+/**
+ * Get the value in the `k`th non-empty slot in `s`, counting from zero in
+ * index order.
+ */
+void *sparse_value_at(const sparse s, int k) {
+  assert(k < (size_t) s->count);
+  return s->values[k];
+}
+
+/**
+ * Internal helper; binary searches for the position of the first entry whose
+ * index is at least `i` (which is `count` if there is none).
+ */
+static int find_entry(const sparse s, int i) {
+  int low = 0;
+  int high = s->count;
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    if (s->indices[mid] < i) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+/**
+ * Internal helper; inserts the entry (`i`, `value`) at position `k` in the
+ * entry arrays, doubling their capacity when necessary.
+ */
+static void add_entry(sparse s, int k, int i, void *value) {
+  if (s->count == s->capacity) {
+    s->capacity *= 2;
+    s->indices = realloc(s->indices, s->capacity * sizeof (int));
+    assert(s->indices != NULL);
+    s->values = realloc(s->values, s->capacity * sizeof (void *));
+    assert(s->values != NULL);
+  }
+
+  int remaining = s->count - k;
+  memmove(&s->indices[k + 1], &s->indices[k], remaining * sizeof (int));
+  memmove(&s->values[k + 1], &s->values[k], remaining * sizeof (void *));
+  s->indices[k] = i;
+  s->values[k] = value;
+  s->count += 1;
+}
+
+/**
+ * Internal helper; removes the entry at position `k` in the entry arrays.
+ */
+static void remove_entry(sparse s, int k) {
+  int remaining = s->count - k - 1;
+  memmove(&s->indices[k], &s->indices[k + 1], remaining * sizeof (int));
+  memmove(&s->values[k], &s->values[k + 1], remaining * sizeof (void *));
+  s->count -= 1;
+}
@@ -0,0 +1,98 @@
+#ifndef __SPARSE_H
+#define __SPARSE_H
+
+#include <stdbool.h>
+
+/**
+ * Type: Sparse Vector
+ *
+ * Maintains an ordered, variable-length list of values in which most slots are
+ * expected to be empty (NULL). Only the non-NULL entries are stored, as sorted
+ * index/value pairs, so memory use and iteration time are proportional to the
+ * number of non-NULL entries rather than to the size of the list. Supports the
+ * same operations as `vector`, where getting an empty slot yields NULL and
+ * setting a slot to NULL empties it.
+ */
+typedef struct sparse *sparse;
+
+/**
+ * Create a new, empty sparse vector.
+ *
+ * The returned sparse vector will have been dynamically allocated, and must be
+ * destroyed after use using `sparse_destroy`.
+ */
+sparse sparse_create();
+
+/**
+ * Clean up a sparse vector after use.
+ *
+ * Like `vector_destroy`, this frees only the sparse vector's own storage, and
+ * not the values that it references.
+ */
+void sparse_destroy(sparse s);
+
+/**
+ * Get the size (number of slots, empty or not) of `s`.
+ */
+int sparse_size(const sparse s);
+
+/**
+ * Determine whether `i` is a valid index within `s`.
+ */
+bool sparse_in_bounds(const sparse s, int i);
+
+/**
+ * Write `value` at the existing index `i` in `s`. Writing NULL empties the
+ * slot.
+ */
+void sparse_set(sparse s, int i, void *value);
+
+/**
+ * Get the value at index `i` in `s`, or NULL if the slot is empty.
+ */
+void *sparse_get(const sparse s, int i);
+
+/**
+ * Insert `value` (which may be NULL) at index `i` in `s`, shifting all
+ * existing slots starting at index `i` one position to the right.
+ */
+void sparse_insert(sparse s, int i, void *value);
+
+/**
+ * Remove and return the value (or NULL) at index `i` of `s`.
+ */
+void *sparse_remove(sparse s, int i);
+
+/**
+ * Push `value` (which may be NULL) onto the end of `s`.
+ */
+void sparse_push(sparse s, void *value);
+
+/**
+ * Remove and return the value (or NULL) at the end of `s`.
+ */
+void *sparse_pop(sparse s);
+
+/**
+ * Get the number of non-empty slots in `s`.
+ */
+int sparse_count(const sparse s);
+
+/**
+ * Get the index of the `k`th non-empty slot in `s`, counting from zero in
+ * index order. Together with `sparse_value_at`, this iterates over just the
+ * non-empty slots:
+ *
+ *   for (int k = 0; k < sparse_count(s); k += 1) {
+ *     use(sparse_index_at(s, k), sparse_value_at(s, k));
+ *   }
+ */
+int sparse_index_at(const sparse s, int k);
+
+/**
+ * Get the value in the `k`th non-empty slot in `s`, counting from zero in
+ * index order.
+ */
+void *sparse_value_at(const sparse s, int k);
+
+#endif
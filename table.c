@@ -0,0 +1,206 @@
+#include "table.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+/**
+ * Struct: Table
+ *
+ * Implements the storage for the table type defined in `table.h`. The table
+ * struct uses these members:
+ *  `columns`  Array of `count` column arrays; column `c` stores field `c` of
+ *             every record, back to back.
+ *  `widths`   Width in bytes of each field.
+ *  `count`    Number of fields per record.
+ *  `capacity` Max number of records each column can store without
+ *             reallocating.
+ *  `size`     Number of records currently stored.
+ */
+struct table {
+  unsigned char **columns;
+  size_t *widths;
+  int count;
+  int capacity;
+  int size;
+};
+
+// Two internal helper functions. Implemented at the bottom of this file.
+static unsigned char *get_field(const table t, int i, int c);
+static void extend_if_necessary(table t);
+
+/**
+ * Create a new, empty table of records with `columns` fields, where field `c`
+ * is `widths[c]` bytes wide (*e.g.*, `sizeof (double)`).
+ *
+ * The returned table will have been dynamically allocated, and must be
+ * destroyed after use using `table_destroy`.
+ */
+table table_create(int columns, const size_t *widths) {
+  assert(columns > 0);
+  table t = malloc(sizeof (struct table));
+  assert(t != NULL);
+  t->columns = malloc(columns * sizeof (unsigned char *));
+  assert(t->columns != NULL);
+  t->widths = malloc(columns * sizeof (size_t));
+  assert(t->widths != NULL);
+  memcpy(t->widths, widths, columns * sizeof (size_t));
+
+  // Like a vector, each column starts with space for a single element.
+  for (int c = 0; c < columns; c += 1) {
+    t->columns[c] = malloc(widths[c]);
+    assert(t->columns[c] != NULL);
+  }
+
+  t->count = columns;
+  t->capacity = 1;
+  t->size = 0;
+  return t;
+}
+
+/**
+ * Clean up a table after use.
+ */
+void table_destroy(table t) {
+  for (int c = 0; c < t->count; c += 1) {
+    free(t->columns[c]);
+  }
+  free(t->columns);
+  free(t->widths);
+  free(t);
+}
+
+/**
+ * Get the size (number of records stored) of `t`.
+ */
+int table_size(const table t) {
+  return t->size;
+}
+
+/**
+ * Get the number of fields in each record of `t`.
+ */
+int table_columns(const table t) {
+  return t->count;
+}
+
+/**
+ * Determine whether `i` is a valid record index within `t`.
+ */
+bool table_in_bounds(const table t, int i) {
+  return i < (size_t) t->size;
+}
+
+/**
+ * Get a pointer to the contiguous array holding field `c` of every record in
+ * `t`, in order. The pointer is invalidated by any operation that adds records
+ * to the table.
+ */
+void *table_column(const table t, int c) {
+  assert(c < (size_t) t->count);
+  return t->columns[c];
+}
+
+/**
+ * Get a pointer to field `c` of the record at index `i` in `t`. The pointer is
+ * invalidated by any operation that adds records to the table.
+ */
+void *table_field(const table t, int i, int c) {
+  return get_field(t, i, c);
+}
+
+/**
+ * Overwrite the record at the existing index `i` in `t`. For each field `c`,
+ * `fields[c]` points to the new field data to copy in.
+ */
+void table_set(table t, int i, const void *const *fields) {
+  for (int c = 0; c < t->count; c += 1) {
+    memcpy(get_field(t, i, c), fields[c], t->widths[c]);
+  }
+}
+
+/**
+ * Copy out the record at index `i` in `t`. For each field `c`, the field data
+ * is copied to `fields[c]`.
+ */
+void table_get(const table t, int i, void *const *fields) {
+  for (int c = 0; c < t->count; c += 1) {
+    memcpy(fields[c], get_field(t, i, c), t->widths[c]);
+  }
+}
+
+/**
+ * Insert a record at index `i` in `t`, shifting all existing records starting
+ * at index `i` one position to the right. For each field `c`, `fields[c]`
+ * points to the field data to copy in.
+ */
+void table_insert(table t, int i, const void *const *fields) {
+  t->size += 1;
+  extend_if_necessary(t);
+
+  // Shift the tail of every column right by one field to make room, just as
+  // `vector_insert` does for its single array of pointers.
+  int remaining = t->size - i - 1;
+  for (int c = 0; c < t->count; c += 1) {
+    unsigned char *target = get_field(t, i, c);
+    size_t width = t->widths[c];
+    memmove(target + width, target, remaining * width);
+    memcpy(target, fields[c], width);
+  }
+}
+
+/**
+ * Remove the record at index `i` of `t`. If `fields` is not NULL, the removed
+ * record is first copied out, as by `table_get`.
+ */
+void table_remove(table t, int i, void *const *fields) {
+  if (fields != NULL) table_get(t, i, fields);
+
+  // Shift the tail of every column left by one field to cover the removed
+  // record.
+  int remaining = t->size - i - 1;
+  for (int c = 0; c < t->count; c += 1) {
+    unsigned char *target = get_field(t, i, c);
+    size_t width = t->widths[c];
+    memmove(target, target + width, remaining * width);
+  }
+  t->size -= 1;
+}
+
+/**
+ * Push a record onto the end of `t`, as by `table_insert`.
+ */
+void table_push(table t, const void *const *fields) {
+  table_insert(t, t->size, fields);
+}
+
+/**
+ * Remove the record at the end of `t`, as by `table_remove`.
+ */
+void table_pop(table t, void *const *fields) {
+  table_remove(t, t->size - 1, fields);
+}
+
+/**
+ * Internal helper; computes a pointer to field `c` of the record at index `i`
+ * within `t`.
+ */
+static unsigned char *get_field(const table t, int i, int c) {
+  assert(i < (size_t) t->size);
+  assert(c < (size_t) t->count);
+  return t->columns[c] + i * t->widths[c];
+}
+
+/**
+ * Internal helper; doubles the capacity of every column when necessary
+ * (*i.e.*, the table's `size` becomes greater than its `capacity`).
+ */
+static void extend_if_necessary(table t) {
+  if (t->size > t->capacity) {
+    t->capacity *= 2;
+    for (int c = 0; c < t->count; c += 1) {
+      t->columns[c] = realloc(t->columns[c], t->capacity * t->widths[c]);
+      assert(t->columns[c] != NULL);
+    }
+  }
+}
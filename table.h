@@ -0,0 +1,97 @@
+#ifndef __TABLE_H
+#define __TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Type: Table
+ *
+ * Maintains an ordered, variable-length list of records, each made up of a
+ * fixed number of fields of fixed sizes. Unlike a `vector`, which stores
+ * references, a table stores the field data itself, and it does so by column:
+ * every field is kept in its own contiguous array. Pushing, popping, inserting
+ * and removing records keeps all columns in lockstep, while a scan of a single
+ * field touches only that field's column, and can run as a simple loop over a
+ * plain C array.
+ */
+typedef struct table *table;
+
+/**
+ * Create a new, empty table of records with `columns` fields, where field `c`
+ * is `widths[c]` bytes wide (*e.g.*, `sizeof (double)`).
+ *
+ * The returned table will have been dynamically allocated, and must be
+ * destroyed after use using `table_destroy`.
+ */
+table table_create(int columns, const size_t *widths);
+
+/**
+ * Clean up a table after use.
+ */
+void table_destroy(table t);
+
+/**
+ * Get the size (number of records stored) of `t`.
+ */
+int table_size(const table t);
+
+/**
+ * Get the number of fields in each record of `t`.
+ */
+int table_columns(const table t);
+
+/**
+ * Determine whether `i` is a valid record index within `t`.
+ */
+bool table_in_bounds(const table t, int i);
+
+/**
+ * Get a pointer to the contiguous array holding field `c` of every record in
+ * `t`, in order. The pointer is invalidated by any operation that adds records
+ * to the table.
+ */
+void *table_column(const table t, int c);
+
+/**
+ * Get a pointer to field `c` of the record at index `i` in `t`. The pointer is
+ * invalidated by any operation that adds records to the table.
+ */
+void *table_field(const table t, int i, int c);
+
+/**
+ * Overwrite the record at the existing index `i` in `t`. For each field `c`,
+ * `fields[c]` points to the new field data to copy in.
+ */
+void table_set(table t, int i, const void *const *fields);
+
+/**
+ * Copy out the record at index `i` in `t`. For each field `c`, the field data
+ * is copied to `fields[c]`.
+ */
+void table_get(const table t, int i, void *const *fields);
+
+/**
+ * Insert a record at index `i` in `t`, shifting all existing records starting
+ * at index `i` one position to the right. For each field `c`, `fields[c]`
+ * points to the field data to copy in.
+ */
+void table_insert(table t, int i, const void *const *fields);
+
+/**
+ * Remove the record at index `i` of `t`. If `fields` is not NULL, the removed
+ * record is first copied out, as by `table_get`.
+ */
+void table_remove(table t, int i, void *const *fields);
+
+/**
+ * Push a record onto the end of `t`, as by `table_insert`.
+ */
+void table_push(table t, const void *const *fields);
+
+/**
+ * Remove the record at the end of `t`, as by `table_remove`.
+ */
+void table_pop(table t, void *const *fields);
+
+#endif
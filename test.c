@@ -0,0 +1,84 @@
+#include "vector.h"
+#include "diff.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <assert.h>
+
+// Size of the vectors diffed.
+#define SIZE (1 << 20)
+
+/**
+ * Build a vector of the `n` distinct values 1 to `n`.
+ */
+vector make_vector(int n) {
+  vector v = vector_create();
+  for (int i = 1; i <= n; i += 1) vector_push(v, (void *) (intptr_t) i);
+  return v;
+}
+
+/**
+ * Check that patching a copy of `a` with `d` gives the values of `b`.
+ */
+void check_patch(const vector a, const vector b, const diff d) {
+  vector c = vector_copy(a);
+  vector_patch(c, d);
+  assert(vector_equal(c, b));
+  vector_destroy(c);
+}
+
+/**
+ * Scattered edits, too many for one Myers search, must still give a diff the
+ * size of the change rather than of the vector.
+ */
+void test_diff_scattered(int sets, int moves) {
+  vector a = make_vector(SIZE);
+  vector b = vector_copy(a);
+  int stride = SIZE / (sets + moves + 1);
+  for (int k = 0; k < sets; k += 1) {
+    vector_set(b, (k + 1) * stride, (void *) (intptr_t) -(k + 1));
+  }
+
+  // Each move removes a value and inserts a new one a little further on,
+  // shifting the values in between.
+  for (int k = 0; k < moves; k += 1) {
+    int i = (sets + k + 1) * stride;
+    vector_remove(b, i);
+    vector_insert(b, i + stride / 2, (void *) (intptr_t) -(sets + k + 1));
+  }
+
+  diff d = vector_diff(a, b, map_equal_pointer);
+  printf("%4d sets, %4d moves: %d hunks, %d values\n", sets, moves,
+      diff_hunks(d), diff_size(d));
+  assert(diff_size(d) <= 2 * (sets + moves));
+  check_patch(a, b, d);
+  diff_destroy(d);
+  vector_destroy(a);
+  vector_destroy(b);
+}
+
+/**
+ * Vectors with nothing in common are replaced wholesale.
+ */
+void test_diff_unrelated() {
+  vector a = make_vector(4096);
+  vector b = vector_create();
+  for (int i = 1; i <= 3000; i += 1) vector_push(b, (void *) (intptr_t) -i);
+  diff d = vector_diff(a, b, map_equal_pointer);
+  assert(diff_hunks(d) == 1);
+  assert(diff_size(d) == 4096 + 3000);
+  check_patch(a, b, d);
+  diff_destroy(d);
+  vector_destroy(a);
+  vector_destroy(b);
+}
+
+int main() {
+  test_diff_scattered(100, 0);
+  test_diff_scattered(600, 0);
+  test_diff_scattered(5000, 0);
+  test_diff_scattered(0, 600);
+  test_diff_scattered(2000, 2000);
+  test_diff_unrelated();
+  printf("All tests passed.\n");
+  return 0;
+}
@@ -1,28 +1,153 @@
 #include "vector.h"
+#include "rng.h"
+#include "map.h"
+#include "bloom.h"
+#include "ebr.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
 #include <assert.h>
+#include <sys/mman.h>
 
 /**
  * Struct: Vector
  * 
  * Implements the storage for the vector type defined in `vector.h`. The vector
- * struct uses three members:
+ * struct uses three main members:
  *  `elems`    Array of pointers; stores the vector's contents.
  *  `capacity` Max number of elements the vector can store without
  *             reallocating.
  *  `size`     Number of elements currently stored.
+ *
+ * When a membership filter is enabled with `vector_filter`, these are used
+ * too:
+ *  `filter`   Bloom filter over the hashes of the (non-NULL) values added to
+ *             the vector since it was last rebuilt.
+ *  `stale`    Number of values that have since been removed or overwritten,
+ *             and so may still be in the filter despite no longer being in
+ *             the vector.
+ *  `hash`     Client hash function for values.
+ *  `equal`    Client equality function for values.
+ *
+ * Clients subscribed to changes with `vector_subscribe` are kept in the
+ * `listeners` array (with `listener_count` slots, some of which may be free).
+ *
+ * While a transaction is open (`in_txn`), every change is also recorded, in
+ * order, in the `undo` log (holding `undo_count` of `undo_capacity` changes),
+ * so that it can be reversed if the transaction is aborted.
+ *
+ * When a snapshot of the vector is taken, it shares the vector's `elems`
+ * array, and is kept in `pinned` until the vector is next modified. Then the
+ * vector copies the array for itself, leaving the original to the snapshot.
+ *
+ * If `vector_use_ebr` has been called, `ebr` is the writing thread's record,
+ * through which old element arrays are retired when the vector grows.
+ *
+ * `alloc` holds the `enum vector_alloc` flags chosen with `vector_use_alloc`,
+ * which say how the element array is allocated.
+ *
+ * `seq` counts the vector's modifications twice over: it is odd while one is
+ * under way, and even otherwise, so that readers on other threads can tell
+ * whether one overlapped their reads (see `vector_read_begin`).
  */
 struct vector {
   void **elems;
   int capacity;
   int size;
+  bloom filter;
+  int stale;
+  map_hash_fn hash;
+  map_equal_fn equal;
+  struct listener *listeners;
+  int listener_count;
+  bool in_txn;
+  struct change *undo;
+  int undo_count;
+  int undo_capacity;
+  snapshot pinned;
+  ebr_thread ebr;
+  int alloc;
+  unsigned seq;
 };
 
-// Two internal helper functions. Implemented at the bottom of this file.
+struct listener {
+  vector_listener fn;
+  void *context;
+};
+
+/**
+ * Struct: Iterator
+ *
+ * An iterator over `v` holds the index `next` of the next value to return,
+ * and whether to prefetch the values that slots point to (`values`).
+ */
+struct vector_iter {
+  vector v;
+  int next;
+  bool values;
+};
+
+struct change {
+  enum vector_op op;
+  int i;
+  void *old_value;
+};
+
+/**
+ * Struct: Snapshot
+ *
+ * A snapshot holds the `size` values in `elems` as they were when it was
+ * taken. `refs` counts the clients holding the snapshot, plus one for the
+ * vector while it still shares `elems`; whoever drops the last reference
+ * frees the snapshot (and, if the vector has let go of it, `elems` too).
+ */
+struct snapshot {
+  void **elems;
+  int size;
+  atomic_int refs;
+};
+
+// Internal helper functions. Implemented at the bottom of this file.
 static void **get_element(const vector v, int i);
-static void extend_if_necessary(vector v);
+static void check_indices(const vector v, const int *indices, int n);
+static void reverse_range(vector v, int start, int end);
+static int gallop(const vector v, int from, const void *key,
+    vector_compare_fn compare, bool upper);
+static void filter_add(vector v, const void *value);
+static void insert_at(vector v, int i, void *value);
+static void *remove_at(vector v, int i);
+static void notify(vector v, enum vector_op op, int i, void *old_value,
+    void *new_value);
+static bool listening(const vector v);
+static void **save_for_listeners(const vector v);
+static void notify_reordered(vector v, void **before);
+static void undo_change(vector v, const struct change *change);
+static void rebuild_filter(vector v);
+static void own_elems(vector v);
+static void write_begin(vector v);
+static void write_end(vector v);
+static void **alloc_elems(const vector v, int capacity);
+static void replace_elems(vector v, void **elems);
+static void set_capacity(vector v, int capacity, int live);
+static void extend_if_necessary(vector v, int size);
+static void set_size(vector v, int size);
+
+// How many indices ahead batched operations prefetch elements from.
+#define PREFETCH_DISTANCE 16
+
+// How many indices ahead iterators prefetch slots from. Slots are read in
+// order, so this runs further ahead than the values they point to, so that
+// the slot is already cached by the time its value is prefetched.
+#define SLOT_PREFETCH_DISTANCE 64
+
+// How many values deep comparison checks at a time for identical pointers.
+#define COMPARE_CHUNK 64
+
+// Sizes of a cache line and of a (transparent) huge page, in bytes.
+#define CACHE_LINE 64
+#define HUGE_PAGE (2 << 20)
 
 /**
  * Create a new, empty vector.
@@ -34,7 +159,7 @@ vector vector_create() {
 
   // Allocate space for the vector itself, as well as its internal element 
   // storage (capacity 1 to start).
-  vector v = malloc(sizeof (vector));
+  vector v = malloc(sizeof (struct vector));
   assert(v != NULL);
   v->elems = malloc(sizeof (void *));
   assert(v->elems != NULL);
@@ -44,6 +169,30 @@ vector vector_create() {
   v->capacity = 1;
   v->size = 0;
 
+  // No filter until one is asked for.
+  v->filter = NULL;
+  v->stale = 0;
+  v->hash = NULL;
+  v->equal = NULL;
+
+  // Nor any listeners.
+  v->listeners = NULL;
+  v->listener_count = 0;
+
+  // Nor a transaction.
+  v->in_txn = false;
+  v->undo = NULL;
+  v->undo_count = 0;
+  v->undo_capacity = 0;
+
+  // Nor a snapshot.
+  v->pinned = NULL;
+
+  // Growth frees old storage at once, until asked to do otherwise.
+  v->ebr = NULL;
+  v->alloc = 0;
+  v->seq = 0;
+
   return v;
 }
 
@@ -56,15 +205,59 @@ vector vector_create() {
  * values, that memory must be freed by the client beforehand.
  */
 void vector_destroy(vector v) {
-  free(v->elems);
+  if (v->filter != NULL) bloom_destroy(v->filter);
+  free(v->listeners);
+  free(v->undo);
+
+  // A snapshot still in use keeps the element array; we just give up our
+  // reference to it.
+  if (v->pinned != NULL && atomic_load(&v->pinned->refs) > 1) {
+    snapshot_release(v->pinned);
+  } else {
+    free(v->pinned);
+    free(v->elems);
+  }
   free(v);
 }
 
+/**
+ * Create a new vector holding the same values as `v`, in the same order, and
+ * allocated the same way (see `vector_use_alloc`).
+ *
+ * The returned vector will have been dynamically allocated, and must be
+ * destroyed after use using `vector_destroy`.
+ */
+vector vector_copy(const vector v) {
+
+  // Allocate the copy's storage once, at its final size and the way `v` is
+  // allocated (even if that size is no bigger than a new vector's), and fill
+  // it with a single `memcpy`.
+  vector copy = vector_create();
+  copy->alloc = v->alloc;
+  copy->capacity = v->size > 1 ? v->size : 1;
+  replace_elems(copy, alloc_elems(copy, copy->capacity));
+  memcpy(copy->elems, v->elems, v->size * sizeof (void *));
+  copy->size = v->size;
+  return copy;
+}
+
+/**
+ * Make sure `v` has room for at least `capacity` values, so that it can grow
+ * to that size without reallocating.
+ */
+void vector_reserve(vector v, int capacity) {
+  if (capacity <= v->capacity) return;
+  write_begin(v);
+  own_elems(v);
+  set_capacity(v, capacity, v->size);
+  write_end(v);
+}
+
 /**
  * Get the size (number of elements stored) of `v`.
  */
 int vector_size(const vector v) {
-  return v->size;
+  return __atomic_load_n(&v->size, __ATOMIC_RELAXED);
 }
 
 /**
@@ -78,10 +271,20 @@ bool vector_in_bounds(const vector v, int i) {
  * Write `value` at the existing index `i` in the vector `v`.
  */
 void vector_set(vector v, int i, void *value) {
+  write_begin(v);
+  own_elems(v);
 
   // We use the `get_element` helper routine to safely get a pointer to the
   // given index's location in the vector's own internal storage.
-  *get_element(v, i) = value;
+  void **target = get_element(v, i);
+  void *old_value = *target;
+  *target = value;
+  write_end(v);
+
+  // The overwritten value may linger in the filter.
+  filter_add(v, value);
+  v->stale += 1;
+  notify(v, VECTOR_SET, i, old_value, value);
 }
 
 /**
@@ -101,9 +304,746 @@ void *vector_get(const vector v, int i) {
  * This will shift all existing elements, starting at index `i`, one position
  * to the right, so that `value` can occupiy the space at index `i`.
  */
-void vector_insert(vector v,int i, void *value) {
-  v->size += 1;
-  extend_if_necessary(v);
+void vector_insert(vector v, int i, void *value) {
+  insert_at(v, i, value);
+  notify(v, VECTOR_INSERT, i, NULL, value);
+}
+
+/**
+ * Remove and return the value at index `i` of the vector `v`.
+ */
+void *vector_remove(vector v, int i) {
+  void *result = remove_at(v, i);
+  notify(v, VECTOR_REMOVE, i, result, NULL);
+  return result;
+}
+
+/**
+ * Push `value` onto the end of the vector `v`.
+ */
+void vector_push(vector v, void *value) {
+
+  // Offload to the existing insertion routine.
+  insert_at(v, v->size, value);
+  notify(v, VECTOR_PUSH, v->size - 1, NULL, value);
+}
+
+/**
+ * Remove and return the value at the end of the vector `v`.
+ */
+void *vector_pop(vector v) {
+
+  // Offload to the existing removal routine.
+  void *result = remove_at(v, v->size - 1);
+  notify(v, VECTOR_POP, v->size, result, NULL);
+  return result;
+}
+
+/**
+ * Push the `n` values in the array `values` onto the end of the vector `v`, in
+ * order.
+ */
+void vector_push_many(vector v, void *const *values, int n) {
+
+  // Grow once for the whole batch, then copy it in with a single `memcpy`
+  // rather than pushing one value at a time.
+  write_begin(v);
+  own_elems(v);
+  int start = v->size;
+  set_size(v, v->size + n);
+  memcpy(&v->elems[start], values, n * sizeof (void *));
+  write_end(v);
+  for (int k = 0; k < n; k += 1) {
+    filter_add(v, values[k]);
+    notify(v, VECTOR_PUSH, start + k, NULL, values[k]);
+  }
+}
+
+/**
+ * Replace the `n` values of `v` starting at index `i` with the `count` values
+ * in `values`, shifting the values after them just once. Once the change is
+ * made, listeners hear of it as `n` removes at `i` followed by `count` inserts.
+ */
+void vector_splice(vector v, int i, int n, void *const *values, int count) {
+  assert(i >= 0 && n >= 0 && i + n <= v->size);
+
+  // Listeners hear about the change only once it is made, so keep the values
+  // it overwrites for them.
+  void **removed = NULL;
+  if (n > 0 && listening(v)) {
+    removed = malloc(n * sizeof (void *));
+    assert(removed != NULL);
+    memcpy(removed, &v->elems[i], n * sizeof (void *));
+  }
+
+  // Grow first if necessary, then slide the tail into its final position
+  // and copy the new values into the gap.
+  write_begin(v);
+  own_elems(v);
+  int tail = v->size - i - n;
+  set_size(v, v->size + count - n);
+  memmove(&v->elems[i + count], &v->elems[i + n], tail * sizeof (void *));
+  memcpy(&v->elems[i], values, count * sizeof (void *));
+  write_end(v);
+
+  // Report the change as if the old values were removed one by one, and then
+  // the new ones inserted.
+  if (removed != NULL) {
+    for (int k = 0; k < n; k += 1) {
+      notify(v, VECTOR_REMOVE, i, removed[k], NULL);
+    }
+    free(removed);
+  }
+  for (int k = 0; k < count; k += 1) {
+    filter_add(v, values[k]);
+    notify(v, VECTOR_INSERT, i + k, NULL, values[k]);
+  }
+  v->stale += n;
+}
+
+/**
+ * Read the values at the `n` indices in `indices` from `v`, writing the value
+ * at `indices[k]` to `out[k]`.
+ */
+void vector_gather(const vector v, const int *indices, int n, void **out) {
+
+  // Bounds are checked once for the whole batch, leaving a tight loop with no
+  // per-element checks. On large vectors the indices are usually scattered,
+  // so we prefetch a little way ahead to overlap the cache misses.
+  check_indices(v, indices, n);
+  for (int k = 0; k < n; k += 1) {
+    if (k + PREFETCH_DISTANCE < n) {
+      __builtin_prefetch(&v->elems[indices[k + PREFETCH_DISTANCE]]);
+    }
+    out[k] = v->elems[indices[k]];
+  }
+}
+
+/**
+ * Write the `n` values in `values` into `v`, writing `values[k]` at the
+ * existing index `indices[k]`. If an index repeats, the last write wins.
+ */
+void vector_scatter(vector v, const int *indices, void *const *values, int n) {
+  check_indices(v, indices, n);
+  for (int k = 0; k < n; k += 1) {
+    if (k + PREFETCH_DISTANCE < n) {
+      __builtin_prefetch(&v->elems[indices[k + PREFETCH_DISTANCE]], 1);
+    }
+    write_begin(v);
+    own_elems(v);
+    void *old_value = v->elems[indices[k]];
+    v->elems[indices[k]] = values[k];
+    write_end(v);
+    filter_add(v, values[k]);
+    notify(v, VECTOR_SET, indices[k], old_value, values[k]);
+  }
+  v->stale += n;
+}
+
+/**
+ * Rearrange the values of `v` in place, so that the value previously at index
+ * `perm[i]` ends up at index `i`. `perm` must hold each index of `v` exactly
+ * once.
+ */
+void vector_permute(vector v, const int *perm) {
+  check_indices(v, perm, v->size);
+  void **before = save_for_listeners(v);
+  write_begin(v);
+  own_elems(v);
+
+  // Follow each cycle of the permutation, pulling values along it one step and
+  // using a bitmap (one bit per element) to mark the slots already filled.
+  // This avoids a second copy of the whole array.
+  int words = (v->size + 63) / 64;
+  uint64_t *done = calloc(words > 0 ? words : 1, sizeof (uint64_t));
+  assert(done != NULL);
+  for (int start = 0; start < v->size; start += 1) {
+    if (done[start / 64] >> (start % 64) & 1) continue;
+    void *first = v->elems[start];
+    int i = start;
+    while (true) {
+      done[i / 64] |= (uint64_t) 1 << (i % 64);
+      int next = perm[i];
+      if (next == start) {
+        v->elems[i] = first;
+        break;
+      }
+
+      // Reaching a filled slot by any other route means `perm` repeats an
+      // index.
+      assert(!(done[next / 64] >> (next % 64) & 1));
+      v->elems[i] = v->elems[next];
+      i = next;
+    }
+  }
+  free(done);
+  write_end(v);
+  notify_reordered(v, before);
+}
+
+/**
+ * Reverse the order of the values of `v` in place.
+ */
+void vector_reverse(vector v) {
+  void **before = save_for_listeners(v);
+  write_begin(v);
+  own_elems(v);
+  reverse_range(v, 0, v->size);
+  write_end(v);
+  notify_reordered(v, before);
+}
+
+/**
+ * Rotate the values of `v` in place by `k` positions to the left, so that the
+ * value previously at index `k` ends up at index 0. Negative `k` rotates to
+ * the right.
+ */
+void vector_rotate(vector v, int k) {
+  if (v->size == 0) return;
+  k %= v->size;
+  if (k < 0) k += v->size;
+
+  // Reversing the two sections and then the whole array swaps the sections
+  // with no extra storage, touching each element just twice.
+  void **before = save_for_listeners(v);
+  write_begin(v);
+  own_elems(v);
+  reverse_range(v, 0, k);
+  reverse_range(v, k, v->size);
+  reverse_range(v, 0, v->size);
+  write_end(v);
+  notify_reordered(v, before);
+}
+
+/**
+ * Shuffle the values of `v` into a uniformly random order, drawing random
+ * numbers from `r`.
+ */
+void vector_shuffle(vector v, rng r) {
+
+  // Fisher-Yates, swapping directly in the array.
+  void **before = save_for_listeners(v);
+  write_begin(v);
+  own_elems(v);
+  for (int i = v->size - 1; i > 0; i -= 1) {
+    int j = rng_below(r, i + 1);
+    void *tmp = v->elems[i];
+    v->elems[i] = v->elems[j];
+    v->elems[j] = tmp;
+  }
+  write_end(v);
+  notify_reordered(v, before);
+}
+
+/**
+ * Choose `k` distinct indices of `v` uniformly at random, drawing random
+ * numbers from `r`, and push the values at those indices onto `out`. `k` must
+ * not exceed the size of `v`.
+ */
+void vector_sample(const vector v, int k, rng r, vector out) {
+  assert(k >= 0 && k <= v->size);
+
+  // Floyd's algorithm: for each of the last `k` indices `j` in turn, pick a
+  // random index up to `j`, falling back to `j` itself if that one's already
+  // been chosen. This takes O(k) time and space, regardless of the vector's
+  // size. Indices are stored in the map directly as pointer-sized keys.
+  map chosen = map_create(map_hash_pointer, map_equal_pointer);
+  for (int j = v->size - k; j < v->size; j += 1) {
+    int t = rng_below(r, j + 1);
+    if (map_contains(chosen, (void *) (intptr_t) t)) t = j;
+    map_put(chosen, (void *) (intptr_t) t, NULL);
+    vector_push(out, v->elems[t]);
+  }
+  map_destroy(chosen);
+}
+
+/**
+ * Enable a membership filter on `v`, to speed up `vector_contains`. Values are
+ * hashed with `hash` and compared with `equal`, which are never called with
+ * NULL.
+ */
+void vector_filter(vector v, map_hash_fn hash, map_equal_fn equal) {
+  v->hash = hash;
+  v->equal = equal;
+  rebuild_filter(v);
+}
+
+/**
+ * Determine whether `v` contains `value`.
+ */
+bool vector_contains(vector v, const void *value) {
+
+  // The filter is rebuilt lazily, once enough values have left the vector
+  // (or enough have been added) that false positives start to become common.
+  if (v->filter != NULL && value != NULL) {
+    if (v->stale > v->size / 2 || v->size > bloom_capacity(v->filter)) {
+      rebuild_filter(v);
+    }
+
+    // A negative answer from the filter is definitive, so most lookups of
+    // absent values end here without scanning.
+    if (!bloom_test(v->filter, v->hash(value))) return false;
+  }
+
+  for (int i = 0; i < v->size; i += 1) {
+    void *elem = v->elems[i];
+    if (elem == value) return true;
+    if (v->equal != NULL && elem != NULL && value != NULL &&
+        v->equal(elem, value)) return true;
+  }
+  return false;
+}
+
+/**
+ * Merge the values of `a` and `b`, which must each be sorted according to
+ * `compare`, pushing the combined sorted sequence onto `out`. Values that
+ * compare equal keep their relative order, with those from `a` first.
+ */
+void vector_merge(const vector a, const vector b, vector_compare_fn compare,
+    vector out) {
+
+  // Alternate between the two inputs, copying whole runs at once. Each run's
+  // end is found by galloping, so merging a small vector into a large one
+  // takes only a logarithmic number of comparisons per small-vector value
+  // (though every value must still be copied).
+  int i = 0;
+  int j = 0;
+  while (i < a->size && j < b->size) {
+    int run = gallop(a, i, b->elems[j], compare, true);
+    vector_push_many(out, &a->elems[i], run - i);
+    i = run;
+    if (i == a->size) break;
+    run = gallop(b, j, a->elems[i], compare, false);
+    vector_push_many(out, &b->elems[j], run - j);
+    j = run;
+  }
+  vector_push_many(out, &a->elems[i], a->size - i);
+  vector_push_many(out, &b->elems[j], b->size - j);
+}
+
+/**
+ * Push the sorted union of `a` and `b`, which must each be sorted according to
+ * `compare`, onto `out`. A value present in both is pushed once, taken from
+ * `a`.
+ */
+void vector_set_union(const vector a, const vector b,
+    vector_compare_fn compare, vector out) {
+  int i = 0;
+  int j = 0;
+  while (i < a->size && j < b->size) {
+
+    // Copy the run of `a` below the next value of `b`, then, if the two heads
+    // match, take just one of them, then copy the run of `b` below the next
+    // value of `a`.
+    int run = gallop(a, i, b->elems[j], compare, false);
+    vector_push_many(out, &a->elems[i], run - i);
+    i = run;
+    if (i == a->size) break;
+    if (compare(a->elems[i], b->elems[j]) == 0) {
+      vector_push(out, a->elems[i]);
+      i += 1;
+      j += 1;
+      if (i == a->size) break;
+    }
+    run = gallop(b, j, a->elems[i], compare, false);
+    vector_push_many(out, &b->elems[j], run - j);
+    j = run;
+  }
+  vector_push_many(out, &a->elems[i], a->size - i);
+  vector_push_many(out, &b->elems[j], b->size - j);
+}
+
+/**
+ * Push the sorted intersection of `a` and `b`, which must each be sorted
+ * according to `compare`, onto `out`. Matching values are taken from `a`.
+ */
+void vector_set_intersection(const vector a, const vector b,
+    vector_compare_fn compare, vector out) {
+  int i = 0;
+  int j = 0;
+  while (i < a->size && j < b->size) {
+
+    // Leapfrog: gallop `b` forward to the head of `a`, then, if they don't
+    // match, `a` forward to the head of `b`, and so on until they meet. Each
+    // round after the first moves both sides on by at least one value, so
+    // there are no more rounds than values in the smaller vector, and a
+    // skewed intersection costs two searches per small-vector value at most.
+    j = gallop(b, j, a->elems[i], compare, false);
+    if (j == b->size) break;
+    if (compare(a->elems[i], b->elems[j]) == 0) {
+      vector_push(out, a->elems[i]);
+      i += 1;
+      j += 1;
+    } else {
+      i = gallop(a, i, b->elems[j], compare, false);
+    }
+  }
+}
+
+/**
+ * Push the sorted difference of `a` and `b` (the values of `a` that are not in
+ * `b`), which must each be sorted according to `compare`, onto `out`.
+ */
+void vector_set_difference(const vector a, const vector b,
+    vector_compare_fn compare, vector out) {
+  int i = 0;
+  int j = 0;
+  while (i < a->size && j < b->size) {
+
+    // Skip `b` forward to the head of `a`; on a match drop that value,
+    // otherwise keep the whole run of `a` below the head of `b`.
+    j = gallop(b, j, a->elems[i], compare, false);
+    if (j == b->size) break;
+    if (compare(a->elems[i], b->elems[j]) == 0) {
+      i += 1;
+      j += 1;
+    } else {
+      int run = gallop(a, i, b->elems[j], compare, false);
+      vector_push_many(out, &a->elems[i], run - i);
+      i = run;
+    }
+  }
+  vector_push_many(out, &a->elems[i], a->size - i);
+}
+
+/**
+ * Determine whether `a` and `b` hold the same values (the same pointers) in
+ * the same order.
+ */
+bool vector_equal(const vector a, const vector b) {
+  return a->size == b->size &&
+      memcmp(a->elems, b->elems, a->size * sizeof (void *)) == 0;
+}
+
+/**
+ * Determine whether `a` and `b` hold equal values in the same order,
+ * comparing values with `equal`, which is never called with NULL.
+ */
+bool vector_equal_deep(const vector a, const vector b, map_equal_fn equal) {
+  if (a->size != b->size) return false;
+
+  // Vectors compared this way often share most of their values (one may be a
+  // copy of the other), so check each chunk for identical pointers with one
+  // `memcmp`, and only call `equal` within chunks that differ. Either way,
+  // stop at the first mismatch.
+  for (int start = 0; start < a->size; start += COMPARE_CHUNK) {
+    int end = a->size - start < COMPARE_CHUNK ? a->size : start + COMPARE_CHUNK;
+    if (memcmp(&a->elems[start], &b->elems[start],
+        (end - start) * sizeof (void *)) == 0) {
+      continue;
+    }
+    for (int i = start; i < end; i += 1) {
+      void *x = a->elems[i];
+      void *y = b->elems[i];
+      if (x == y) continue;
+      if (x == NULL || y == NULL || !equal(x, y)) return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Subscribe to changes to `v`: `listener` will be called, with `context`,
+ * after every modification. Returns an id for use with `vector_unsubscribe`.
+ */
+int vector_subscribe(vector v, vector_listener listener, void *context) {
+
+  // Reuse a free slot if there is one, so that ids stay small.
+  int id = 0;
+  while (id < v->listener_count && v->listeners[id].fn != NULL) id += 1;
+  if (id == v->listener_count) {
+    v->listener_count += 1;
+    v->listeners = realloc(v->listeners,
+        v->listener_count * sizeof (struct listener));
+    assert(v->listeners != NULL);
+  }
+  v->listeners[id].fn = listener;
+  v->listeners[id].context = context;
+  return id;
+}
+
+/**
+ * Stop the listener with the given `id` (from `vector_subscribe`) from
+ * receiving changes to `v`.
+ */
+void vector_unsubscribe(vector v, int id) {
+  assert(id < (size_t) v->listener_count && v->listeners[id].fn != NULL);
+  v->listeners[id].fn = NULL;
+}
+
+/**
+ * Begin a transaction on `v`, which must not already have one open. Changes
+ * made from now on can be undone all together with `vector_txn_abort`, or
+ * kept with `vector_txn_commit`.
+ */
+void vector_txn_begin(vector v) {
+  assert(!v->in_txn);
+  v->in_txn = true;
+  v->undo_count = 0;
+}
+
+/**
+ * Commit the open transaction on `v`, keeping all its changes.
+ */
+void vector_txn_commit(vector v) {
+  assert(v->in_txn);
+  v->in_txn = false;
+  v->undo_count = 0;
+}
+
+/**
+ * Abort the open transaction on `v`, undoing all its changes, so that `v`
+ * holds exactly the values it held when the transaction began.
+ */
+void vector_txn_abort(vector v) {
+  assert(v->in_txn);
+
+  // Close the transaction first, so that undoing isn't itself logged. Changes
+  // are undone newest first, each by its inverse, which listeners hear about
+  // like any other change.
+  v->in_txn = false;
+  for (int k = v->undo_count - 1; k >= 0; k -= 1) {
+    undo_change(v, &v->undo[k]);
+  }
+  v->undo_count = 0;
+}
+
+/**
+ * Copy the objects pointed to by the values of `v` into a single new arena,
+ * one after another in index order, and replace each value with a pointer to
+ * its copy. `size` gives each object's size, and `copy` copies it. Returns the
+ * arena, which must be freed (with `free`) once none of the copies is needed.
+ *
+ * NULL values are left alone, and a value held at several indices is copied
+ * just once. Listeners hear about each value replaced as a set, with the
+ * original object as the old value. `v` must not have a transaction open, as
+ * aborting it would bring the originals back.
+ *
+ * The original objects are no longer referenced by `v` afterwards, so `copy`
+ * may free each one once it has copied it, but only if nothing is subscribed
+ * to `v`: listeners are handed the originals after every copy has been made.
+ */
+void *vector_compact_values(vector v, vector_size_fn size,
+    vector_copy_fn copy) {
+  assert(!v->in_txn);
+
+  // Lay the objects out first, mapping each distinct one to its offset in the
+  // arena (shifted left by one; the low bit later marks it as copied), so that
+  // the arena can be allocated in one go. Each is aligned as `malloc` would
+  // align it.
+  size_t alignment = _Alignof (max_align_t);
+  map offsets = map_create(map_hash_pointer, map_equal_pointer);
+  size_t total = 0;
+  for (int i = 0; i < v->size; i += 1) {
+    void *value = v->elems[i];
+    if (value == NULL || map_contains(offsets, value)) continue;
+    map_put(offsets, value, (void *) (total << 1));
+    total += (size(value) + alignment - 1) / alignment * alignment;
+  }
+
+  // Start the arena on a cache line, so that the objects share as few lines
+  // as possible.
+  char *arena = aligned_alloc(CACHE_LINE,
+      total > 0 ? (total + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE :
+      CACHE_LINE);
+  assert(arena != NULL);
+
+  // Then copy each object the first time it is found, and point every slot
+  // holding it at the copy.
+  void **before = save_for_listeners(v);
+  write_begin(v);
+  own_elems(v);
+  for (int i = 0; i < v->size; i += 1) {
+    void *value = v->elems[i];
+    if (value == NULL) continue;
+    uintptr_t entry = (uintptr_t) map_get(offsets, value);
+    void *target = arena + (entry >> 1);
+    if (!(entry & 1)) {
+      copy(target, value);
+      map_put(offsets, value, (void *) (entry | 1));
+    }
+    v->elems[i] = target;
+  }
+  write_end(v);
+  map_destroy(offsets);
+  notify_reordered(v, before);
+
+  // Every value has changed, so the filter must start afresh.
+  if (v->filter != NULL) rebuild_filter(v);
+  return arena;
+}
+
+/**
+ * Take a snapshot of the current values of `v`, which can be read (from any
+ * thread) while `v` goes on changing. Snapshots must be taken on the thread
+ * that modifies `v` (or otherwise in step with its modifications), and must
+ * be released after use using `snapshot_release`.
+ */
+snapshot vector_snapshot(vector v) {
+
+  // Until `v` changes, all its snapshots are the same, so they share one.
+  if (v->pinned == NULL) {
+    v->pinned = malloc(sizeof (struct snapshot));
+    assert(v->pinned != NULL);
+    v->pinned->elems = v->elems;
+    v->pinned->size = v->size;
+    atomic_init(&v->pinned->refs, 1);
+  }
+  atomic_fetch_add(&v->pinned->refs, 1);
+  return v->pinned;
+}
+
+/**
+ * Get the number of values in the snapshot `s`.
+ */
+int snapshot_size(const snapshot s) {
+  return s->size;
+}
+
+/**
+ * Get the value at index `i` in the snapshot `s`.
+ */
+void *snapshot_get(const snapshot s, int i) {
+  assert(i < (size_t) s->size);
+  return s->elems[i];
+}
+
+/**
+ * Release the snapshot `s` after use. This may be done from any thread.
+ */
+void snapshot_release(snapshot s) {
+  if (atomic_fetch_sub(&s->refs, 1) == 1) {
+    free(s->elems);
+    free(s);
+  }
+}
+
+/**
+ * Make `v` retire the element arrays it outgrows through the reclamation
+ * domain of `writer`, the record of the thread that modifies `v`, rather than
+ * freeing them at once. Readers on other threads that find the array inside
+ * a critical section of the same domain can then go on reading it even if
+ * `v` grows meanwhile.
+ *
+ * Each growth frees the arrays retired before it that no reader can still be
+ * using. The last arrays retired are freed only by later calls to
+ * `ebr_collect` on `writer` (or by `ebr_unregister` or `ebr_destroy`), so a
+ * writer whose vector stops growing should call it now and then.
+ */
+void vector_use_ebr(vector v, ebr_thread writer) {
+  v->ebr = writer;
+}
+
+/**
+ * Choose how the element array of `v` is allocated, as a combination of the
+ * `enum vector_alloc` flags (or 0 for the default), and reallocate it that way
+ * now.
+ */
+void vector_use_alloc(vector v, int flags) {
+  write_begin(v);
+  own_elems(v);
+  v->alloc = flags;
+  void **elems = alloc_elems(v, v->capacity);
+  memcpy(elems, v->elems, v->size * sizeof (void *));
+  replace_elems(v, elems);
+  write_end(v);
+}
+
+/**
+ * Begin an optimistic read of `v` from a thread other than the one modifying
+ * it, returning a token for `vector_read_retry`. Waits for any modification
+ * under way to finish first.
+ */
+unsigned vector_read_begin(const vector v) {
+  unsigned seq = __atomic_load_n(&v->seq, __ATOMIC_ACQUIRE);
+  while (seq & 1) seq = __atomic_load_n(&v->seq, __ATOMIC_ACQUIRE);
+  return seq;
+}
+
+/**
+ * Determine whether `v` has been modified since the optimistic read begun by
+ * `vector_read_begin` (which returned `seq`), in which case anything read in
+ * between must be discarded and read again.
+ */
+bool vector_read_retry(const vector v, unsigned seq) {
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  return __atomic_load_n(&v->seq, __ATOMIC_RELAXED) != seq;
+}
+
+/**
+ * Get the value at index `i` in `v` into `value`, within an optimistic read.
+ * Returns `false` if `i` is out of bounds, rather than failing, since a
+ * concurrent modification may have made it so.
+ */
+bool vector_try_get(const vector v, int i, void **value) {
+
+  // The writer publishes a bigger array before a bigger size, so the array we
+  // find is always at least as big as the size we checked.
+  if (i >= (size_t) __atomic_load_n(&v->size, __ATOMIC_ACQUIRE)) return false;
+  void **elems = __atomic_load_n(&v->elems, __ATOMIC_ACQUIRE);
+  *value = __atomic_load_n(&elems[i], __ATOMIC_RELAXED);
+  return true;
+}
+
+/**
+ * Create an iterator over the values of `v`, from the first. If `values` is
+ * `true`, values are treated as pointers, and the memory they point to is
+ * prefetched ahead of time too.
+ *
+ * The returned iterator will have been dynamically allocated, and must be
+ * destroyed after use using `vector_iter_destroy`. `v` must not be modified
+ * while it is in use.
+ */
+vector_iter vector_iter_create(const vector v, bool values) {
+  vector_iter it = malloc(sizeof (struct vector_iter));
+  assert(it != NULL);
+  it->v = v;
+  it->next = 0;
+  it->values = values;
+  return it;
+}
+
+/**
+ * Clean up an iterator after use.
+ */
+void vector_iter_destroy(vector_iter it) {
+  free(it);
+}
+
+/**
+ * Copy the next values (at most `n` of them) from the iterator `it` into
+ * `out`, and return how many were copied; 0 once all have been.
+ */
+int vector_iter_next_batch(vector_iter it, void **out, int n) {
+  vector v = it->v;
+  int start = it->next;
+  int end = v->size - start < n ? v->size : start + n;
+
+  // Prefetch one cache line of slots at a time, well ahead, and (if asked)
+  // the value of each slot a shorter way ahead.
+  for (int i = start; i < end; i += 1) {
+    if (i % (CACHE_LINE / sizeof (void *)) == 0 &&
+        i + SLOT_PREFETCH_DISTANCE < v->size) {
+      __builtin_prefetch(&v->elems[i + SLOT_PREFETCH_DISTANCE]);
+    }
+    if (it->values && i + PREFETCH_DISTANCE < v->size) {
+      void *ahead = v->elems[i + PREFETCH_DISTANCE];
+      if (ahead != NULL) __builtin_prefetch(ahead);
+    }
+    out[i - start] = v->elems[i];
+  }
+  it->next = end;
+  return end - start;
+}
+
+/**
+ * Internal helper; inserts `value` at index `i` in `v`, without notifying
+ * listeners.
+ */
+static void insert_at(vector v, int i, void *value) {
+  write_begin(v);
+  own_elems(v);
+  set_size(v, v->size + 1);
 
   // Get a reference to the desired element position within the vector's own 
   // internal storage.
@@ -116,12 +1056,17 @@ void vector_insert(vector v,int i, void *value) {
   memmove(target + 1, target, remaining * sizeof (void *));
 
   *target = value;
+  write_end(v);
+  filter_add(v, value);
 }
 
 /**
- * Remove and return the value at index `i` of the vector `v`.
+ * Internal helper; removes and returns the value at index `i` of `v`, without
+ * notifying listeners.
  */
-void *vector_remove(vector v, int i) {
+static void *remove_at(vector v, int i) {
+  write_begin(v);
+  own_elems(v);
 
   // Get a reference to the desired element position within the vector's own 
   // internal storage, and save the found value to return.
@@ -133,49 +1078,339 @@ void *vector_remove(vector v, int i) {
   // element.
   int remaining = v->size - i - 1;
   memmove(target, target + 1, remaining * sizeof (void *));
-  v->size -= 1;
+  set_size(v, v->size - 1);
+  write_end(v);
+
+  // Bloom filters can't forget, so the removed value lingers in the filter
+  // until it is next rebuilt.
+  v->stale += 1;
 
   return result;
 }
 
 /**
- * Push `value` onto the end of the vector `v`.
+ * Internal helper; computes a pointer to the memory location for a given index
+ * `i` within `v`.
  */
-void vector_push(vector v, void *value) {
+static void **get_element(const vector v, int i) {
+  assert(i < (size_t) v->size);
+  return &v->elems[i];
+}
 
-  // Offload to the existing insertion routine.
-  vector_insert(v, v->size, value);
+/**
+ * Internal helper; checks that all `n` indices in `indices` are valid within
+ * `v`. Finding the extremes first keeps the loop free of branches, so it runs
+ * much faster than checking each index as it is used.
+ */
+static void check_indices(const vector v, const int *indices, int n) {
+  int min = 0;
+  int max = 0;
+  for (int k = 0; k < n; k += 1) {
+    min = indices[k] < min ? indices[k] : min;
+    max = indices[k] > max ? indices[k] : max;
+  }
+  assert(min >= 0 && (n == 0 || max < v->size));
 }
 
 /**
- * Remove and return the value at the end of the vector `v`.
+ * Internal helper; reverses the values of `v` from index `start` up to (but
+ * not including) index `end`.
  */
-void *vector_pop(vector v) {
+static void reverse_range(vector v, int start, int end) {
+  for (int i = start, j = end - 1; i < j; i += 1, j -= 1) {
+    void *tmp = v->elems[i];
+    v->elems[i] = v->elems[j];
+    v->elems[j] = tmp;
+  }
+}
+
+/**
+ * Internal helper; finds the first index from `from` onwards at which the
+ * sorted values of `v` are greater than (if `upper`) or at least (otherwise)
+ * `key`, or the size of `v` if there is none.
+ *
+ * The search gallops: it probes 1, 2, 4, ... positions ahead until it
+ * overshoots, and then binary searches the last gap. This takes time
+ * logarithmic in the distance moved, rather than in the size of `v`.
+ */
+static int gallop(const vector v, int from, const void *key,
+    vector_compare_fn compare, bool upper) {
+  int low = from;
+  int high = from;
+  int step = 1;
+  while (high < v->size) {
+    int c = compare(v->elems[high], key);
+    if (upper ? c > 0 : c >= 0) break;
+    low = high + 1;
+    high += step;
+    step *= 2;
+  }
+  if (high > v->size) high = v->size;
 
-  // Offload to `vector_remove`.
-  return vector_remove(v, v->size - 1);
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    int c = compare(v->elems[mid], key);
+    if (upper ? c > 0 : c >= 0) {
+      high = mid;
+    } else {
+      low = mid + 1;
+    }
+  }
+  return low;
 }
 
 /**
- * Internal helper; computes a pointer to the memory location for a given index
- * `i` within `v`.
+ * Internal helper; adds `value` to the membership filter of `v`, if it has
+ * one.
  */
-static void **get_element(const vector v, int i) {
-  assert(i < (size_t) v->size);
-  return &v->elems[i];
+static void filter_add(vector v, const void *value) {
+  if (v->filter != NULL && value != NULL) {
+    bloom_add(v->filter, v->hash(value));
+  }
+}
+
+/**
+ * Internal helper; replaces the membership filter of `v` with a fresh one
+ * holding exactly the current values, with room for the vector to double.
+ */
+static void rebuild_filter(vector v) {
+  if (v->filter != NULL) bloom_destroy(v->filter);
+  v->filter = bloom_create(v->size * 2 > 64 ? v->size * 2 : 64);
+  v->stale = 0;
+  for (int i = 0; i < v->size; i += 1) {
+    filter_add(v, v->elems[i]);
+  }
+}
+
+/**
+ * Internal helper; tells every listener on `v` about a change, and records it
+ * in the undo log if a transaction is open.
+ */
+static void notify(vector v, enum vector_op op, int i, void *old_value,
+    void *new_value) {
+  if (v->in_txn) {
+    if (v->undo_count == v->undo_capacity) {
+      v->undo_capacity = v->undo_capacity ? v->undo_capacity * 2 : 16;
+      v->undo = realloc(v->undo, v->undo_capacity * sizeof (struct change));
+      assert(v->undo != NULL);
+    }
+    struct change *change = &v->undo[v->undo_count];
+    change->op = op;
+    change->i = i;
+    change->old_value = old_value;
+    v->undo_count += 1;
+  }
+
+  for (int id = 0; id < v->listener_count; id += 1) {
+    struct listener *l = &v->listeners[id];
+    if (l->fn != NULL) l->fn(l->context, op, i, old_value, new_value);
+  }
+}
+
+/**
+ * Internal helper; determines whether anyone is listening to changes to `v`,
+ * or a transaction is open to log them.
+ */
+static bool listening(const vector v) {
+  if (v->in_txn) return true;
+  for (int id = 0; id < v->listener_count; id += 1) {
+    if (v->listeners[id].fn != NULL) return true;
+  }
+  return false;
+}
+
+/**
+ * Internal helper; before an operation that reorders values in bulk, takes a
+ * copy of the values of `v` if anyone is listening or a transaction is open
+ * (or returns NULL if not).
+ */
+static void **save_for_listeners(const vector v) {
+  if (!listening(v)) return NULL;
+
+  void **before = malloc((v->size > 0 ? v->size : 1) * sizeof (void *));
+  assert(before != NULL);
+  memcpy(before, v->elems, v->size * sizeof (void *));
+  return before;
+}
+
+/**
+ * Internal helper; after an operation that reordered values in bulk, reports
+ * each slot that changed (compared to the copy `before`, which may be NULL if
+ * there were no listeners) as a set, then frees the copy.
+ */
+static void notify_reordered(vector v, void **before) {
+  if (before == NULL) return;
+  for (int i = 0; i < v->size; i += 1) {
+    if (before[i] != v->elems[i]) {
+      notify(v, VECTOR_SET, i, before[i], v->elems[i]);
+    }
+  }
+  free(before);
+}
+
+/**
+ * Internal helper; reverses the logged `change` to `v`, and tells listeners.
+ */
+static void undo_change(vector v, const struct change *change) {
+  int i = change->i;
+  switch (change->op) {
+    case VECTOR_SET: {
+      write_begin(v);
+      own_elems(v);
+      void *value = v->elems[i];
+      v->elems[i] = change->old_value;
+      write_end(v);
+      filter_add(v, change->old_value);
+      v->stale += 1;
+      notify(v, VECTOR_SET, i, value, change->old_value);
+      break;
+    }
+    case VECTOR_INSERT:
+      notify(v, VECTOR_REMOVE, i, remove_at(v, i), NULL);
+      break;
+    case VECTOR_PUSH:
+      notify(v, VECTOR_POP, i, remove_at(v, i), NULL);
+      break;
+    case VECTOR_REMOVE:
+      insert_at(v, i, change->old_value);
+      notify(v, VECTOR_INSERT, i, NULL, change->old_value);
+      break;
+    case VECTOR_POP:
+      insert_at(v, i, change->old_value);
+      notify(v, VECTOR_PUSH, i, NULL, change->old_value);
+      break;
+  }
+}
+
+/**
+ * Internal helper; before `v` is modified, gives it back sole use of its
+ * element array, if it is sharing it with a snapshot.
+ */
+static void own_elems(vector v) {
+  snapshot s = v->pinned;
+  if (s == NULL) return;
+  v->pinned = NULL;
+
+  // If every client has already released the snapshot, nobody else can be
+  // reading the array (new snapshots are only taken in step with changes), so
+  // we can keep it. Otherwise, we copy it and leave the original to them.
+  if (atomic_load(&s->refs) == 1) {
+    free(s);
+    return;
+  }
+  void **elems = alloc_elems(v, v->capacity);
+  memcpy(elems, v->elems, v->size * sizeof (void *));
+  v->elems = elems;
+  snapshot_release(s);
+}
+
+/**
+ * Internal helper; marks the start of a modification of `v`, for readers.
+ */
+static void write_begin(vector v) {
+  __atomic_store_n(&v->seq, v->seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/**
+ * Internal helper; marks the end of a modification of `v`, for readers.
+ */
+static void write_end(vector v) {
+  __atomic_store_n(&v->seq, v->seq + 1, __ATOMIC_RELEASE);
 }
 
 /**
  * Internal helper; doubles the vector's internal storage capacity when 
- * necessary (*i.e.*, the vector's `size` becomes greater than its `capacity`).
+ * necessary (*i.e.*, the vector is about to hold `size` values, more than its
+ * `capacity`).
  */
-static void extend_if_necessary(vector v) {
-  if (v->size > v->capacity) {
+static void extend_if_necessary(vector v, int size) {
+  if (size > v->capacity) {
 
     // Doubling the capacity when necessary allows for an amortized constant 
-    // runtime for extensions. Using `realloc` will conveniently copy the 
-    // vector's existing contents to any newly allocated memory.
-    v->capacity *= 2;
-    v->elems = realloc(v->elems, v->capacity * sizeof (void *));
+    // runtime for extensions. `set_capacity` carries the vector's existing
+    // contents over to the new array, with `realloc` when it can. Bulk
+    // operations may need more than one doubling at once.
+    int capacity = v->capacity;
+    while (capacity < size) capacity *= 2;
+    set_capacity(v, capacity, v->size);
+  }
+}
+
+/**
+ * Internal helper; changes the size of `v` to `size`, growing its storage
+ * first if necessary. The new array is published before the new size, so
+ * that an optimistic reader never pairs a size with a smaller array. Every
+ * change to the size of a live vector goes through here, as readers load it
+ * atomically.
+ */
+static void set_size(vector v, int size) {
+  extend_if_necessary(v, size);
+  __atomic_store_n(&v->size, size, __ATOMIC_RELEASE);
+}
+
+/**
+ * Internal helper; reallocates the element array of `v` to hold `capacity`
+ * values, keeping the first `live` of them.
+ */
+static void set_capacity(vector v, int capacity, int live) {
+  v->capacity = capacity;
+  if (v->ebr == NULL && v->alloc == 0) {
+    v->elems = realloc(v->elems, capacity * sizeof (void *));
+    assert(v->elems != NULL);
+    return;
+  }
+
+  // `realloc` can't keep to our alignment, and readers may still be using
+  // the old array, so copy into a new one instead.
+  void **elems = alloc_elems(v, capacity);
+  memcpy(elems, v->elems, live * sizeof (void *));
+  replace_elems(v, elems);
+}
+
+/**
+ * Internal helper; allocates an element array for `v` with room for
+ * `capacity` values, as chosen with `vector_use_alloc`.
+ */
+static void **alloc_elems(const vector v, int capacity) {
+  size_t bytes = capacity * sizeof (void *);
+  if (v->alloc == 0) {
+    void **elems = malloc(bytes);
+    assert(elems != NULL);
+    return elems;
+  }
+
+  // Large arrays are aligned to a huge page, and the kernel asked to back
+  // them with huge pages, so that random access over them needs far fewer
+  // TLB entries. Anything else is aligned to a cache line. `aligned_alloc`
+  // wants the size to be a multiple of the alignment.
+  size_t alignment = CACHE_LINE;
+  if ((v->alloc & VECTOR_ALLOC_HUGE) && bytes >= HUGE_PAGE) {
+    alignment = HUGE_PAGE;
+  }
+  bytes = (bytes + alignment - 1) / alignment * alignment;
+  void **elems = aligned_alloc(alignment, bytes);
+  assert(elems != NULL);
+#ifdef MADV_HUGEPAGE
+  if (alignment == HUGE_PAGE) madvise(elems, bytes, MADV_HUGEPAGE);
+#endif
+  return elems;
+}
+
+/**
+ * Internal helper; makes `elems` the element array of `v`, freeing the old
+ * one (or retiring it, if readers may still be using it).
+ */
+static void replace_elems(vector v, void **elems) {
+  void **old_elems = v->elems;
+  __atomic_store_n(&v->elems, elems, __ATOMIC_RELEASE);
+  if (v->ebr != NULL) {
+    // Arrays are retired only about log2(n) times over the life of a vector,
+    // far too rarely to fill a batch, so collect on every one. Each call also
+    // frees the arrays retired before, once readers have moved on.
+    ebr_retire(v->ebr, old_elems);
+    ebr_collect(v->ebr);
+  } else {
+    free(old_elems);
   }
 }
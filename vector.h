@@ -2,6 +2,10 @@
 #define __VECTOR_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include "rng.h"
+#include "map.h"
+#include "ebr.h"
 
 /**
  * Type: Vector
@@ -13,6 +17,75 @@
  */
 typedef struct vector *vector;
 
+/**
+ * Type: Iterator
+ *
+ * Reads the values of a vector in order, a batch at a time, prefetching ahead
+ * of the reads.
+ */
+typedef struct vector_iter *vector_iter;
+
+/**
+ * Type: Snapshot
+ *
+ * A read-only view of a vector's values as they were at one moment, taken
+ * with `vector_snapshot`.
+ */
+typedef struct snapshot *snapshot;
+
+/**
+ * Comparison function for vector values, returning a negative number, zero,
+ * or a positive number when `a` sorts before, equal to, or after `b`.
+ */
+typedef int (*vector_compare_fn)(const void *a, const void *b);
+
+/**
+ * Size function for vector values, returning the number of bytes that `value`
+ * points to.
+ */
+typedef size_t (*vector_size_fn)(const void *value);
+
+/**
+ * Copy function for vector values, copying the object that `value` points to
+ * into `dest`, which has room for as many bytes as the matching size function
+ * gives. It must not free `value`, unless the function it is passed to says
+ * that it may (see `vector_compact_values`).
+ */
+typedef void (*vector_copy_fn)(void *dest, const void *value);
+
+/**
+ * Kinds of change reported to listeners registered with `vector_subscribe`.
+ */
+enum vector_op {
+  VECTOR_SET,
+  VECTOR_INSERT,
+  VECTOR_REMOVE,
+  VECTOR_PUSH,
+  VECTOR_POP
+};
+
+/**
+ * Ways of allocating a vector's element array, chosen with `vector_use_alloc`:
+ *  `VECTOR_ALLOC_ALIGNED` Align it to a cache line.
+ *  `VECTOR_ALLOC_HUGE`    Once it reaches 2MB, align it to a huge page and ask
+ *                         the kernel to back it with transparent huge pages.
+ */
+enum vector_alloc {
+  VECTOR_ALLOC_ALIGNED = 1,
+  VECTOR_ALLOC_HUGE = 2
+};
+
+/**
+ * Listener for changes to a vector. After each change, it is called with the
+ * `context` given to `vector_subscribe`, the kind of change `op`, the index `i`
+ * that changed, and the value there before (`old_value`, or NULL for inserts
+ * and pushes) and after (`new_value`, or NULL for removes and pops).
+ *
+ * Listeners must not modify the vector they are listening to.
+ */
+typedef void (*vector_listener)(void *context, enum vector_op op, int i,
+    void *old_value, void *new_value);
+
 /**
  * Create a new, empty vector.
  * 
@@ -31,6 +104,21 @@ vector vector_create();
  */
 void vector_destroy(vector v);
 
+/**
+ * Create a new vector holding the same values as `v`, in the same order, and
+ * allocated the same way (see `vector_use_alloc`).
+ *
+ * The returned vector will have been dynamically allocated, and must be
+ * destroyed after use using `vector_destroy`.
+ */
+vector vector_copy(const vector v);
+
+/**
+ * Make sure `v` has room for at least `capacity` values, so that it can grow
+ * to that size without reallocating.
+ */
+void vector_reserve(vector v, int capacity);
+
 /**
  * Get the size (number of elements stored) of `v`.
  */
@@ -74,4 +162,323 @@ void vector_push(vector v, void *value);
  */
 void *vector_pop(vector v);
 
+/**
+ * Push the `n` values in the array `values` onto the end of the vector `v`, in
+ * order.
+ */
+void vector_push_many(vector v, void *const *values, int n);
+
+/**
+ * Replace the `n` values of `v` starting at index `i` with the `count` values
+ * in `values`, shifting the values after them just once. Once the change is
+ * made, listeners hear of it as `n` removes at `i` followed by `count` inserts.
+ */
+void vector_splice(vector v, int i, int n, void *const *values, int count);
+
+/**
+ * Read the values at the `n` indices in `indices` from `v`, writing the value
+ * at `indices[k]` to `out[k]`.
+ *
+ * This is equivalent to calling `vector_get` for each index, but checks bounds
+ * only once for the whole batch, which makes it much faster for large batches.
+ */
+void vector_gather(const vector v, const int *indices, int n, void **out);
+
+/**
+ * Write the `n` values in `values` into `v`, writing `values[k]` at the
+ * existing index `indices[k]`. If an index repeats, the last write wins.
+ *
+ * This is equivalent to calling `vector_set` for each index, but checks bounds
+ * only once for the whole batch, which makes it much faster for large batches.
+ */
+void vector_scatter(vector v, const int *indices, void *const *values, int n);
+
+/**
+ * Rearrange the values of `v` in place, so that the value previously at index
+ * `perm[i]` ends up at index `i`. `perm` must hold each index of `v` exactly
+ * once.
+ */
+void vector_permute(vector v, const int *perm);
+
+/**
+ * Reverse the order of the values of `v` in place.
+ */
+void vector_reverse(vector v);
+
+/**
+ * Rotate the values of `v` in place by `k` positions to the left, so that the
+ * value previously at index `k` ends up at index 0. Negative `k` rotates to
+ * the right.
+ */
+void vector_rotate(vector v, int k);
+
+/**
+ * Shuffle the values of `v` into a uniformly random order, drawing random
+ * numbers from `r`.
+ */
+void vector_shuffle(vector v, rng r);
+
+/**
+ * Choose `k` distinct indices of `v` uniformly at random, drawing random
+ * numbers from `r`, and push the values at those indices onto `out`. `k` must
+ * not exceed the size of `v`.
+ *
+ * This runs in *O*(*k*) time, however large `v` is.
+ */
+void vector_sample(const vector v, int k, rng r, vector out);
+
+/**
+ * Enable a membership filter on `v`, to speed up `vector_contains`. Values are
+ * hashed with `hash` and compared with `equal`, which are never called with
+ * NULL.
+ *
+ * The filter is a bloom filter over the vector's values. It is updated as
+ * values are added, and rebuilt lazily after values are removed, so that most
+ * lookups of absent values can skip the linear scan entirely.
+ */
+void vector_filter(vector v, map_hash_fn hash, map_equal_fn equal);
+
+/**
+ * Determine whether `v` contains `value`.
+ *
+ * Values are compared by pointer, or, if a filter has been enabled with
+ * `vector_filter`, using its equality function.
+ */
+bool vector_contains(vector v, const void *value);
+
+/**
+ * Merge the values of `a` and `b`, which must each be sorted according to
+ * `compare`, pushing the combined sorted sequence onto `out`. Values that
+ * compare equal keep their relative order, with those from `a` first.
+ */
+void vector_merge(const vector a, const vector b, vector_compare_fn compare,
+    vector out);
+
+/**
+ * Push the sorted union of `a` and `b`, which must each be sorted according to
+ * `compare`, onto `out`. A value present in both is pushed once, taken from
+ * `a`.
+ */
+void vector_set_union(const vector a, const vector b,
+    vector_compare_fn compare, vector out);
+
+/**
+ * Push the sorted intersection of `a` and `b`, which must each be sorted
+ * according to `compare`, onto `out`. Matching values are taken from `a`.
+ */
+void vector_set_intersection(const vector a, const vector b,
+    vector_compare_fn compare, vector out);
+
+/**
+ * Push the sorted difference of `a` and `b` (the values of `a` that are not in
+ * `b`), which must each be sorted according to `compare`, onto `out`.
+ *
+ * Like the other merge and set operations, this searches ahead in whichever
+ * vector has the longer run of values, so it is fast even when one vector is
+ * much smaller than the other.
+ */
+void vector_set_difference(const vector a, const vector b,
+    vector_compare_fn compare, vector out);
+
+/**
+ * Determine whether `a` and `b` hold the same values (the same pointers) in
+ * the same order.
+ */
+bool vector_equal(const vector a, const vector b);
+
+/**
+ * Determine whether `a` and `b` hold equal values in the same order,
+ * comparing values with `equal`, which is never called with NULL.
+ *
+ * Values are first compared as pointers, a chunk at a time, so `equal` is
+ * only called for values that are not identical; comparing a vector with a
+ * lightly edited copy of itself costs little more than `vector_equal`.
+ */
+bool vector_equal_deep(const vector a, const vector b, map_equal_fn equal);
+
+/**
+ * Subscribe to changes to `v`: `listener` will be called, with `context`,
+ * after every modification. Returns an id for use with `vector_unsubscribe`.
+ *
+ * Every modifying operation is reported as one or more single-value changes,
+ * which, replayed in order on a copy of the vector, bring it up to date. Bulk
+ * operations report one change per value: `vector_splice` as removes and then
+ * inserts, `vector_push_many` as pushes, `vector_scatter` as sets, and
+ * reordering operations (like `vector_shuffle`) as a set for each index whose
+ * value moved.
+ */
+int vector_subscribe(vector v, vector_listener listener, void *context);
+
+/**
+ * Stop the listener with the given `id` (from `vector_subscribe`) from
+ * receiving changes to `v`.
+ */
+void vector_unsubscribe(vector v, int id);
+
+/**
+ * Begin a transaction on `v`, which must not already have one open. Changes
+ * made from now on can be undone all together with `vector_txn_abort`, or
+ * kept with `vector_txn_commit`.
+ *
+ * Changes within a transaction take effect (and reach listeners) as they are
+ * made, while each is recorded in an undo log; so committing is free, and
+ * aborting costs time proportional to the number of changes made.
+ */
+void vector_txn_begin(vector v);
+
+/**
+ * Commit the open transaction on `v`, keeping all its changes.
+ */
+void vector_txn_commit(vector v);
+
+/**
+ * Abort the open transaction on `v`, undoing all its changes, so that `v`
+ * holds exactly the values it held when the transaction began. Listeners hear
+ * about each change being undone, newest first, as its inverse (a remove for
+ * an insert, a set back to the old value for a set, and so on).
+ */
+void vector_txn_abort(vector v);
+
+/**
+ * Create an iterator over the values of `v`, from the first. If `values` is
+ * `true`, values are treated as pointers, and the memory they point to is
+ * prefetched ahead of time too.
+ *
+ * The returned iterator will have been dynamically allocated, and must be
+ * destroyed after use using `vector_iter_destroy`. `v` must not be modified
+ * while it is in use.
+ *
+ * Scanning a vector of pointers to objects scattered around the heap, and
+ * reading each object, otherwise stalls on a cache miss per object; with
+ * `values`, many of those misses are under way at once.
+ */
+vector_iter vector_iter_create(const vector v, bool values);
+
+/**
+ * Clean up an iterator after use.
+ */
+void vector_iter_destroy(vector_iter it);
+
+/**
+ * Copy the next values (at most `n` of them) from the iterator `it` into
+ * `out`, and return how many were copied; 0 once all have been.
+ */
+int vector_iter_next_batch(vector_iter it, void **out, int n);
+
+/**
+ * Copy the objects pointed to by the values of `v` into a single new arena,
+ * one after another in index order, and replace each value with a pointer to
+ * its copy. `size` gives each object's size, and `copy` copies it. Returns the
+ * arena, which must be freed (with `free`) once none of the copies is needed.
+ *
+ * NULL values are left alone, and a value held at several indices is copied
+ * just once. Listeners hear about each value replaced as a set, with the
+ * original object as the old value. `v` must not have a transaction open, as
+ * aborting it would bring the originals back.
+ *
+ * The original objects are no longer referenced by `v` afterwards, so `copy`
+ * may free each one once it has copied it, but only if nothing is subscribed
+ * to `v`: listeners are handed the originals after every copy has been made.
+ *
+ * Objects allocated one at a time end up scattered around the heap, so that
+ * scanning them takes a cache miss (and, for large vectors, a TLB miss) per
+ * object. Once compacted, they are read sequentially, several to a line.
+ */
+void *vector_compact_values(vector v, vector_size_fn size,
+    vector_copy_fn copy);
+
+/**
+ * Take a snapshot of the current values of `v`, which can be read (from any
+ * thread) while `v` goes on changing. Snapshots must be taken on the thread
+ * that modifies `v` (or otherwise in step with its modifications), and must
+ * be released after use using `snapshot_release`.
+ *
+ * Taking a snapshot copies nothing: the snapshot shares the vector's storage,
+ * and the vector copies it only when next modified, so that a long scan of a
+ * snapshot neither blocks nor sees any later change. Snapshots taken between
+ * the same two changes share a single copy.
+ */
+snapshot vector_snapshot(vector v);
+
+/**
+ * Get the number of values in the snapshot `s`.
+ */
+int snapshot_size(const snapshot s);
+
+/**
+ * Get the value at index `i` in the snapshot `s`.
+ */
+void *snapshot_get(const snapshot s, int i);
+
+/**
+ * Release the snapshot `s` after use. This may be done from any thread.
+ */
+void snapshot_release(snapshot s);
+
+/**
+ * Make `v` retire the element arrays it outgrows through the reclamation
+ * domain of `writer`, the record of the thread that modifies `v`, rather than
+ * freeing them at once. Readers on other threads that find the array inside
+ * a critical section of the same domain can then go on reading it even if
+ * `v` grows meanwhile.
+ *
+ * Each growth frees the arrays retired before it that no reader can still be
+ * using. The last arrays retired are freed only by later calls to
+ * `ebr_collect` on `writer` (or by `ebr_unregister` or `ebr_destroy`), so a
+ * writer whose vector stops growing should call it now and then.
+ *
+ * This only keeps old arrays alive; it does not stop a reader from seeing a
+ * change half made. Shrinking never frees an array, so growth is the only
+ * path that needs this.
+ */
+void vector_use_ebr(vector v, ebr_thread writer);
+
+/**
+ * Choose how the element array of `v` is allocated, as a combination of the
+ * `enum vector_alloc` flags (or 0 for the default), and reallocate it that way
+ * now.
+ *
+ * Huge pages cut the TLB misses of random access over vectors much larger
+ * than the TLB covers with ordinary pages (a few megabytes). With either
+ * flag, growth copies into a fresh array rather than using `realloc`.
+ */
+void vector_use_alloc(vector v, int flags);
+
+/**
+ * Begin an optimistic read of `v` from a thread other than the one modifying
+ * it, returning a token for `vector_read_retry`. Waits for any modification
+ * under way to finish first.
+ *
+ * Optimistic reads let any number of threads read a vector that one thread
+ * modifies, without locks and without readers writing to any shared memory:
+ *
+ *     unsigned seq;
+ *     do {
+ *       seq = vector_read_begin(v);
+ *       size = vector_size(v);
+ *       found = vector_try_get(v, i, &value);
+ *     } while (vector_read_retry(v, seq));
+ *
+ * If the vector may grow meanwhile, its old element array must not be freed
+ * while a reader might still be using it: the writer must call
+ * `vector_use_ebr`, and readers must wrap each read in `ebr_enter` and
+ * `ebr_exit`. Snapshots can't be combined with optimistic reads, as the array
+ * a snapshot takes over is freed without regard to readers.
+ */
+unsigned vector_read_begin(const vector v);
+
+/**
+ * Determine whether `v` has been modified since the optimistic read begun by
+ * `vector_read_begin` (which returned `seq`), in which case anything read in
+ * between must be discarded and read again.
+ */
+bool vector_read_retry(const vector v, unsigned seq);
+
+/**
+ * Get the value at index `i` in `v` into `value`, within an optimistic read.
+ * Returns `false` if `i` is out of bounds, rather than failing, since a
+ * concurrent modification may have made it so.
+ */
+bool vector_try_get(const vector v, int i, void **value);
+
 #endif